@@ -3,22 +3,44 @@
 # Distributed under the MIT software license, see the accompanying
 # file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
-"""Script to find the optimal parameters for the headerssync module through simulation."""
+"""Script to find the optimal parameters for the headerssync module through simulation.
+
+The defaults describe the BewCore main chain (60 second blocks since March 2024). Use the command
+line options to derive parameters for another chain, and put the printed values in its
+CChainParams::m_headers_sync_params."""
 
 from math import log, exp, sqrt
 from datetime import datetime, timedelta
+import argparse
 import random
 
+parser = argparse.ArgumentParser(description=__doc__)
+parser.add_argument("--time", default="2028-10-01",
+                    help="Date (YYYY-MM-DD) at which the parameters should still work fine (default: %(default)s)")
+parser.add_argument("--block-interval", type=int, default=60,
+                    help="Expected block interval in seconds (default: %(default)s)")
+parser.add_argument("--genesis-time", default="2024-03-11",
+                    help="Date (YYYY-MM-DD) of the genesis block (default: %(default)s)")
+parser.add_argument("--minchainwork-headers", type=int, default=None,
+                    help="Number of headers corresponding to the minchainwork parameter "
+                         "(default: the number of blocks from genesis to --time)")
+ARGS = parser.parse_args()
+
 # Parameters:
 
 # Aim for still working fine at some point in the future. [datetime]
-TIME = datetime(2026, 10, 5)
+TIME = datetime.fromisoformat(ARGS.time)
 
 # Expected block interval. [timedelta]
-BLOCK_INTERVAL = timedelta(seconds=600)
+BLOCK_INTERVAL = timedelta(seconds=ARGS.block_interval)
+
+# Timestamp of the genesis block
+GENESIS_TIME = datetime.fromisoformat(ARGS.genesis_time)
 
 # The number of headers corresponding to the minchainwork parameter. [headers]
-MINCHAINWORK_HEADERS = 804000
+MINCHAINWORK_HEADERS = ARGS.minchainwork_headers
+if MINCHAINWORK_HEADERS is None:
+    MINCHAINWORK_HEADERS = (TIME - GENESIS_TIME) // BLOCK_INTERVAL
 
 # Combined processing bandwidth from all attackers to one victim. [bit/s]
 # 6 Gbit/s is approximately the speed at which a single thread of a Ryzen 5950X CPU thread can hash
@@ -117,9 +139,6 @@ HEADER_BATCH_COUNT = 2000
 # Whether or not the offset of which blocks heights get checksummed is randomized.
 RANDOMIZE_OFFSET = True
 
-# Timestamp of the genesis block
-GENESIS_TIME = datetime(2009, 1, 3)
-
 # Derived values:
 
 # What rate of headers worth of RAM attackers are allowed to cause in the victim. [headers/s]
@@ -337,21 +356,19 @@ def analyze(when):
     attack_volume = NET_HEADER_SIZE * MINCHAINWORK_HEADERS
     # And report them.
     print()
-    print("Optimal configuration:")
+    print("Optimal configuration (for CChainParams):")
     print()
-    print("//! Store one header commitment per HEADER_COMMITMENT_PERIOD blocks.")
-    print(f"constexpr size_t HEADER_COMMITMENT_PERIOD{{{period}}};")
-    print()
-    print("//! Only feed headers to validation once this many headers on top have been")
-    print("//! received and validated against commitments.")
-    print(f"constexpr size_t REDOWNLOAD_BUFFER_SIZE{{{bufsize}}};"
-          f" // {bufsize}/{period} = ~{bufsize/period:.1f} commitments")
+    print("m_headers_sync_params = HeadersSyncParams{")
+    print(f"    .commitment_period = {period},")
+    print(f"    .redownload_buffer_size = {bufsize}, // {bufsize}/{period} = ~{bufsize/period:.1f} commitments")
+    print("};")
     print()
     print("Properties:")
     print(f"- Per-peer memory for mainchain sync: {mem_mainchain / 8192:.3f} KiB")
     print(f"- Per-peer memory for timewarp attack: {mem_timewarp / 8192:.3f} KiB")
     print(f"- Attack rate: {1/headers_per_attack:.1f} attacks for 1 header of memory growth")
     print(f"  (where each attack costs {attack_volume / 8388608:.3f} MiB bandwidth)")
-
+    print(f"- Bandwidth for mainchain sync: {2 * attack_volume / 8388608:.3f} MiB"
+          f" (presync and redownload of {MINCHAINWORK_HEADERS} headers)")
 
 analyze(TIME)
@@ -7,6 +7,7 @@
 #include <clientversion.h>
 #include <common/args.h>
 #include <crypto/sha256.h>
+#include <crypto/yespower.h>
 #include <util/fs.h>
 #include <util/strencodings.h>
 
@@ -62,6 +63,7 @@ int main(int argc, char** argv)
     ArgsManager argsman;
     SetupBenchArgs(argsman);
     SHA256AutoDetect();
+    YespowerAutoDetect();
     std::string error;
     if (!argsman.ParseParameters(argc, argv, error)) {
         tfm::format(std::cerr, "Error parsing command line arguments: %s\n", error);
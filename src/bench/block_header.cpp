@@ -0,0 +1,128 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <primitives/block.h>
+#include <random.h>
+#include <streams.h>
+#include <tinyformat.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Counts the allocations made through it, so the DataStream benchmark can
+// report them without replacing the global operator new for every benchmark.
+template <typename T>
+struct CountingAllocator {
+    using value_type = T;
+
+    uint64_t* allocations;
+
+    explicit CountingAllocator(uint64_t* allocations_in) noexcept : allocations{allocations_in} {}
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>& other) noexcept : allocations{other.allocations} {}
+
+    T* allocate(std::size_t n)
+    {
+        ++*allocations;
+        return std::allocator<T>{}.allocate(n);
+    }
+    void deallocate(T* p, std::size_t n) { std::allocator<T>{}.deallocate(p, n); }
+
+    template <typename U>
+    friend bool operator==(const CountingAllocator& a, const CountingAllocator<U>& b) noexcept { return a.allocations == b.allocations; }
+    template <typename U>
+    friend bool operator!=(const CountingAllocator& a, const CountingAllocator<U>& b) noexcept { return a.allocations != b.allocations; }
+};
+
+// DataStream appends every write to the end of its buffer. This stream grows
+// its buffer the same way, so it makes the same allocations, and counts them.
+class AllocationCountingStream
+{
+    uint64_t m_allocations{0};
+    std::vector<std::byte, CountingAllocator<std::byte>> m_data{CountingAllocator<std::byte>{&m_allocations}};
+
+public:
+    AllocationCountingStream() = default;
+    AllocationCountingStream(const AllocationCountingStream&) = delete;
+    AllocationCountingStream& operator=(const AllocationCountingStream&) = delete;
+
+    void write(Span<const std::byte> src) { m_data.insert(m_data.end(), src.begin(), src.end()); }
+
+    template <typename T>
+    AllocationCountingStream& operator<<(const T& obj)
+    {
+        ::Serialize(*this, obj);
+        return *this;
+    }
+
+    uint64_t Allocations() const { return m_allocations; }
+};
+
+static CBlockHeader CreateHeader()
+{
+    FastRandomContext rng(true);
+    CBlockHeader header;
+    header.nVersion = 0x20000000;
+    header.hashPrevBlock = rng.rand256();
+    header.hashMerkleRoot = rng.rand256();
+    header.nTime = rng.rand32();
+    header.nBits = 0x1e0ffff0;
+    header.nNonce = rng.rand32();
+    return header;
+}
+
+// Run fn on a header with a new nonce per call of the benchmark.
+template <typename Fn>
+static void RunPerHeader(benchmark::Bench& bench, Fn fn)
+{
+    CBlockHeader header{CreateHeader()};
+    bench.unit("header").run([&] {
+        ++header.nNonce;
+        fn(header);
+    });
+}
+
+// Serialize a header through a DataStream, like GetPoWHash() used to.
+static void BlockHeaderSerializeDataStream(benchmark::Bench& bench)
+{
+    AllocationCountingStream counting_stream;
+    counting_stream << CreateHeader();
+    bench.name(strprintf("%s (%u allocations per call)", __func__, counting_stream.Allocations()));
+    RunPerHeader(bench, [](const CBlockHeader& header) {
+        DataStream stream{};
+        stream << header;
+        ankerl::nanobench::doNotOptimizeAway(stream.data());
+    });
+}
+
+// The benchmarks below serialize into a fixed-size array and make no
+// allocations.
+static void BlockHeaderSerializeToArray(benchmark::Bench& bench)
+{
+    RunPerHeader(bench, [](const CBlockHeader& header) {
+        ankerl::nanobench::doNotOptimizeAway(header.SerializeToArray());
+    });
+}
+
+static void BlockHeaderGetHash(benchmark::Bench& bench)
+{
+    RunPerHeader(bench, [](const CBlockHeader& header) {
+        ankerl::nanobench::doNotOptimizeAway(header.GetHash());
+    });
+}
+
+static void BlockHeaderGetPoWHash(benchmark::Bench& bench)
+{
+    RunPerHeader(bench, [](const CBlockHeader& header) {
+        ankerl::nanobench::doNotOptimizeAway(header.GetPoWHash());
+    });
+}
+
+BENCHMARK(BlockHeaderSerializeDataStream, benchmark::PriorityLevel::HIGH);
+BENCHMARK(BlockHeaderSerializeToArray, benchmark::PriorityLevel::HIGH);
+BENCHMARK(BlockHeaderGetHash, benchmark::PriorityLevel::HIGH);
+BENCHMARK(BlockHeaderGetPoWHash, benchmark::PriorityLevel::HIGH);
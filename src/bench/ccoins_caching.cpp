@@ -5,6 +5,7 @@
 #include <bench/bench.h>
 #include <coins.h>
 #include <policy/policy.h>
+#include <random.h>
 #include <script/signingprovider.h>
 #include <test/util/transaction_utils.h>
 
@@ -51,3 +52,70 @@ static void CCoinsCaching(benchmark::Bench& bench)
 }
 
 BENCHMARK(CCoinsCaching, benchmark::PriorityLevel::HIGH);
+
+static Coin MakeBenchCoin(FastRandomContext& rng)
+{
+    Coin coin;
+    coin.nHeight = 1;
+    coin.out.nValue = rng.randrange(MAX_MONEY);
+    coin.out.scriptPubKey.assign(uint32_t{25}, 1);
+    return coin;
+}
+
+// Random lookups of coins in a large cache, as when checking the inputs of
+// a block's transactions against a warm cache.
+static void CCoinsCacheLookup(benchmark::Bench& bench)
+{
+    FastRandomContext rng{/*fDeterministic=*/true};
+    CCoinsView dummy;
+    CCoinsViewCache coins{&dummy, /*deterministic=*/true};
+    std::vector<COutPoint> outpoints;
+    for (int i = 0; i < 500'000; ++i) {
+        outpoints.emplace_back(rng.rand256(), rng.randrange(4));
+        coins.AddCoin(outpoints.back(), MakeBenchCoin(rng), /*possible_overwrite=*/false);
+    }
+
+    size_t next{0};
+    bench.batch(1000).unit("lookup").run([&] {
+        for (int i = 0; i < 1000; ++i) {
+            const bool have{coins.HaveCoinInCache(outpoints[next])};
+            assert(have);
+            next = (next + 7919) % outpoints.size();
+        }
+    });
+}
+
+// Connecting UTXO-heavy blocks to a cache on top of another cache, and
+// flushing it into that one: every block spends 2000 of the coins created
+// before it and creates as many.
+static void CCoinsCacheConnectFlush(benchmark::Bench& bench)
+{
+    FastRandomContext rng{/*fDeterministic=*/true};
+    CCoinsView dummy;
+    CCoinsViewCache base{&dummy, /*deterministic=*/true};
+    std::vector<COutPoint> unspent;
+    for (int i = 0; i < 100'000; ++i) {
+        unspent.emplace_back(rng.rand256(), 0);
+        base.AddCoin(unspent.back(), MakeBenchCoin(rng), /*possible_overwrite=*/false);
+    }
+
+    bench.batch(4000).unit("coin").run([&] {
+        CCoinsViewCache block{&base, /*deterministic=*/true};
+        for (int i = 0; i < 2000; ++i) {
+            const size_t pos = rng.randrange(unspent.size());
+            const bool spent{block.SpendCoin(unspent[pos])};
+            assert(spent);
+            unspent[pos] = unspent.back();
+            unspent.pop_back();
+        }
+        for (int i = 0; i < 2000; ++i) {
+            unspent.emplace_back(rng.rand256(), 0);
+            block.AddCoin(unspent.back(), MakeBenchCoin(rng), /*possible_overwrite=*/false);
+        }
+        const bool flushed{block.Flush()};
+        assert(flushed);
+    });
+}
+
+BENCHMARK(CCoinsCacheLookup, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CCoinsCacheConnectFlush, benchmark::PriorityLevel::HIGH);
@@ -17,30 +17,26 @@ static const size_t BATCH_SIZE = 30;
 static const int PREVECTOR_SIZE = 28;
 static const unsigned int QUEUE_BATCH_SIZE = 128;
 
+struct PrevectorJob {
+    prevector<PREVECTOR_SIZE, uint8_t> p;
+    explicit PrevectorJob(FastRandomContext& insecure_rand){
+        p.resize(insecure_rand.randrange(PREVECTOR_SIZE*2));
+    }
+    bool operator()()
+    {
+        return true;
+    }
+};
+
 // This Benchmark tests the CheckQueue with a slightly realistic workload,
 // where checks all contain a prevector that is indirect 50% of the time
 // and there is a little bit of work done between calls to Add.
-static void CCheckQueueSpeedPrevectorJob(benchmark::Bench& bench)
+static void CCheckQueueSpeed(benchmark::Bench& bench, int worker_threads)
 {
-    // We shouldn't ever be running with the checkqueue on a single core machine.
-    if (GetNumCores() <= 1) return;
-
     ECC_Start();
 
-    struct PrevectorJob {
-        prevector<PREVECTOR_SIZE, uint8_t> p;
-        explicit PrevectorJob(FastRandomContext& insecure_rand){
-            p.resize(insecure_rand.randrange(PREVECTOR_SIZE*2));
-        }
-        bool operator()()
-        {
-            return true;
-        }
-    };
     CCheckQueue<PrevectorJob> queue {QUEUE_BATCH_SIZE};
-    // The main thread should be counted to prevent thread oversubscription, and
-    // to decrease the variance of benchmark results.
-    queue.StartWorkerThreads(GetNumCores() - 1);
+    queue.StartWorkerThreads(worker_threads);
 
     // create all the data once, then submit copies in the benchmark.
     FastRandomContext insecure_rand(true);
@@ -64,4 +60,26 @@ static void CCheckQueueSpeedPrevectorJob(benchmark::Bench& bench)
     queue.StopWorkerThreads();
     ECC_Stop();
 }
+
+static void CCheckQueueSpeedPrevectorJob(benchmark::Bench& bench)
+{
+    // We shouldn't ever be running with the checkqueue on a single core machine.
+    if (GetNumCores() <= 1) return;
+
+    // The main thread should be counted to prevent thread oversubscription, and
+    // to decrease the variance of benchmark results.
+    CCheckQueueSpeed(bench, GetNumCores() - 1);
+}
+
+// Scaling with the total number of threads, including the main one, no matter
+// how many cores there are.
+static void CCheckQueueSpeed8Threads(benchmark::Bench& bench) { CCheckQueueSpeed(bench, 7); }
+static void CCheckQueueSpeed16Threads(benchmark::Bench& bench) { CCheckQueueSpeed(bench, 15); }
+static void CCheckQueueSpeed32Threads(benchmark::Bench& bench) { CCheckQueueSpeed(bench, 31); }
+static void CCheckQueueSpeed64Threads(benchmark::Bench& bench) { CCheckQueueSpeed(bench, 63); }
+
 BENCHMARK(CCheckQueueSpeedPrevectorJob, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CCheckQueueSpeed8Threads, benchmark::PriorityLevel::LOW);
+BENCHMARK(CCheckQueueSpeed16Threads, benchmark::PriorityLevel::LOW);
+BENCHMARK(CCheckQueueSpeed32Threads, benchmark::PriorityLevel::LOW);
+BENCHMARK(CCheckQueueSpeed64Threads, benchmark::PriorityLevel::LOW);
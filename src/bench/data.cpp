@@ -9,6 +9,8 @@ namespace data {
 
 #include <bench/data/block413567.raw.h>
 const std::vector<uint8_t> block413567{std::begin(block413567_raw), std::end(block413567_raw)};
+#include <bench/data/yespower_headers.raw.h>
+const std::vector<uint8_t> yespower_headers{std::begin(yespower_headers_raw), std::end(yespower_headers_raw)};
 
 } // namespace data
 } // namespace benchmark
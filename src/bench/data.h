@@ -12,6 +12,8 @@ namespace benchmark {
 namespace data {
 
 extern const std::vector<uint8_t> block413567;
+//! The first 100 headers of a regtest chain, with real yespower proof of work.
+extern const std::vector<uint8_t> yespower_headers;
 
 } // namespace data
 } // namespace benchmark
@@ -0,0 +1,67 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <arith_uint256.h>
+#include <bench/bench.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <headerssync.h>
+#include <primitives/block.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+
+#include <cassert>
+#include <vector>
+
+//! Number of headers in a full HEADERS message (MAX_HEADERS_RESULTS).
+static constexpr size_t HEADERS_BATCH_SIZE{2000};
+//! Number of HEADERS messages in the chain synced by HeadersSyncPresyncRedownload.
+static constexpr size_t HEADERS_BATCHES{50};
+
+// Sync a low-work chain through PRESYNC and REDOWNLOAD with the chain's
+// HeadersSyncParams, one full HEADERS message at a time like net_processing.
+// Every header is processed twice. Proof of work is checked outside of
+// HeadersSyncState, so it is not part of this benchmark.
+static void HeadersSyncPresyncRedownload(benchmark::Bench& bench)
+{
+    const auto testing_setup{MakeNoLogFileContext<const BasicTestingSetup>(ChainType::REGTEST)};
+    const CChainParams& params{Params()};
+
+    const CBlockHeader genesis{params.GenesisBlock()};
+    const uint256 genesis_hash{genesis.GetHash()};
+    CBlockIndex chain_start{genesis};
+    chain_start.phashBlock = &genesis_hash;
+    chain_start.nChainWork = GetBlockProof(chain_start);
+
+    std::vector<std::vector<CBlockHeader>> batches(HEADERS_BATCHES, std::vector<CBlockHeader>(HEADERS_BATCH_SIZE));
+    uint256 prev_hash{genesis_hash};
+    uint32_t time{genesis.nTime};
+    for (auto& batch : batches) {
+        for (CBlockHeader& header : batch) {
+            header.nVersion = genesis.nVersion;
+            header.hashPrevBlock = prev_hash;
+            header.nTime = time += 60;
+            header.nBits = genesis.nBits;
+            prev_hash = header.GetHash();
+        }
+    }
+    const size_t chain_length{HEADERS_BATCHES * HEADERS_BATCH_SIZE};
+    const arith_uint256 minimum_work{chain_start.nChainWork + GetBlockProof(chain_start) * static_cast<uint32_t>(chain_length)};
+
+    bench.batch(chain_length).unit("header").run([&] {
+        HeadersSyncState sync{/*id=*/0, params.GetConsensus(), params.HeadersSync(), &chain_start, minimum_work};
+        size_t accepted{0};
+        for (int pass = 0; pass < 2; ++pass) {
+            for (const auto& batch : batches) {
+                auto result{sync.ProcessNextHeaders(batch, /*full_headers_message=*/true)};
+                assert(result.success);
+                accepted += result.pow_validated_headers.size();
+            }
+        }
+        assert(accepted == chain_length);
+        assert(sync.GetState() == HeadersSyncState::State::FINAL);
+    });
+}
+
+BENCHMARK(HeadersSyncPresyncRedownload, benchmark::PriorityLevel::HIGH);
@@ -0,0 +1,109 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <bench/data.h>
+#include <consensus/validation.h>
+#include <primitives/block.h>
+#include <streams.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+#include <validation.h>
+
+#include <cassert>
+#include <vector>
+
+//! Number of headers in a full HEADERS message (MAX_HEADERS_RESULTS).
+static constexpr size_t HEADERS_BATCH_SIZE{2000};
+//! Number of HEADERS messages processed by ProcessNewBlockHeaders2000.
+static constexpr size_t HEADERS_BATCHES{10};
+
+/** Create count headers extending prev_hash. */
+static std::vector<CBlockHeader> CreateHeaders(size_t count, uint256& prev_hash, uint32_t& time, uint32_t bits)
+{
+    std::vector<CBlockHeader> headers(count);
+    for (CBlockHeader& header : headers) {
+        header.nVersion = 0x20000000;
+        header.hashPrevBlock = prev_hash;
+        header.hashMerkleRoot = prev_hash;
+        header.nTime = time += 60;
+        header.nBits = bits;
+        prev_hash = header.GetHash();
+    }
+    return headers;
+}
+
+// Accept full HEADERS messages of new headers, extending the chain.
+static void ProcessNewBlockHeaders2000(benchmark::Bench& bench)
+{
+    const auto testing_setup{MakeNoLogFileContext<const TestingSetup>(ChainType::REGTEST, {"-checkblockindex=0"})};
+    ChainstateManager& chainman{*testing_setup->m_node.chainman};
+
+    const CBlock& genesis{chainman.GetParams().GenesisBlock()};
+    uint256 prev_hash{genesis.GetHash()};
+    uint32_t time{genesis.nTime};
+    std::vector<std::vector<CBlockHeader>> batches;
+    std::vector<std::vector<uint256>> batch_hashes;
+    for (size_t i = 0; i < HEADERS_BATCHES; ++i) {
+        batches.push_back(CreateHeaders(HEADERS_BATCH_SIZE, prev_hash, time, genesis.nBits));
+        batch_hashes.emplace_back();
+        for (const CBlockHeader& header : batches.back()) batch_hashes.back().push_back(header.GetHash());
+    }
+
+    size_t next{0};
+    bench.epochs(batches.size()).epochIterations(1).batch(HEADERS_BATCH_SIZE).unit("header").run([&] {
+        assert(next < batches.size());
+        // Mining the headers is out of reach for a benchmark, so memoize a
+        // PoW hash that meets any target for each, like HasValidProofOfWork()
+        // leaves the real ones behind.
+        for (const uint256& hash : batch_hashes[next]) MemoizePoWHash(hash, uint256{});
+        BlockValidationState state;
+        bool accepted{chainman.ProcessNewBlockHeaders(batches[next++], /*min_pow_checked=*/true, state)};
+        assert(accepted);
+    });
+}
+
+// Check the proof of work of a HEADERS message of regtest headers mined with
+// real yespower, then accept them, like net_processing does. Once accepted,
+// headers are not checked again, so this runs a single epoch.
+static void ProcessNewBlockHeadersYespower(benchmark::Bench& bench)
+{
+    const auto testing_setup{MakeNoLogFileContext<const TestingSetup>(ChainType::REGTEST, {"-checkblockindex=0"})};
+    ChainstateManager& chainman{*testing_setup->m_node.chainman};
+
+    DataStream stream{benchmark::data::yespower_headers};
+    std::vector<CBlockHeader> headers(stream.size() / BLOCK_HEADER_SIZE);
+    for (CBlockHeader& header : headers) stream >> header;
+    assert(headers.front().hashPrevBlock == chainman.GetParams().GenesisBlock().GetHash());
+
+    bench.epochs(1).epochIterations(1).batch(headers.size()).unit("header").run([&] {
+        bool valid{HasValidProofOfWork(headers, chainman.GetConsensus())};
+        assert(valid);
+        BlockValidationState state;
+        bool accepted{chainman.ProcessNewBlockHeaders(headers, /*min_pow_checked=*/true, state)};
+        assert(accepted);
+    });
+}
+
+// Deserialize a full HEADERS message, which allocates and fills a vector of
+// headers like net_processing does for every message received.
+static void DeserializeHeaders2000(benchmark::Bench& bench)
+{
+    uint256 prev_hash;
+    uint32_t time{0};
+    const std::vector<CBlockHeader> headers{CreateHeaders(HEADERS_BATCH_SIZE, prev_hash, time, 0x207fffff)};
+    DataStream stream{};
+    stream << headers;
+
+    bench.batch(headers.size()).unit("header").run([&] {
+        DataStream data{stream};
+        std::vector<CBlockHeader> received;
+        data >> received;
+        assert(received.size() == HEADERS_BATCH_SIZE);
+    });
+}
+
+BENCHMARK(ProcessNewBlockHeaders2000, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ProcessNewBlockHeadersYespower, benchmark::PriorityLevel::HIGH);
+BENCHMARK(DeserializeHeaders2000, benchmark::PriorityLevel::HIGH);
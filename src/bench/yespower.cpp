@@ -0,0 +1,147 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chainparams.h>
+#include <common/args.h>
+#include <consensus/params.h>
+#include <crypto/yespower.h>
+#include <primitives/block.h>
+#include <random.h>
+#include <tinyformat.h>
+#include <uint256.h>
+#include <util/chaintype.h>
+#include <validation.h>
+
+#include <cassert>
+#include <vector>
+
+//! Number of headers in a full HEADERS message (MAX_HEADERS_RESULTS).
+static constexpr size_t HEADERS_BATCH_SIZE{2000};
+
+static std::vector<CBlockHeader> CreateHeaders(size_t count)
+{
+    FastRandomContext rng(true);
+    std::vector<CBlockHeader> headers(count);
+    uint256 prev{rng.rand256()};
+    for (CBlockHeader& header : headers) {
+        header.nVersion = 0x20000000;
+        header.hashPrevBlock = prev;
+        header.hashMerkleRoot = rng.rand256();
+        header.nTime = rng.rand32();
+        // An easy target (with the raised powLimit below) lets every header
+        // pass, so HasValidProofOfWork never returns early.
+        header.nBits = 0x2100ffff;
+        header.nNonce = rng.rand32();
+        prev = header.GetHash();
+    }
+    return headers;
+}
+
+// Hash a single header with the given yespower implementation.
+static void YespowerHash(benchmark::Bench& bench, const char* name, yespower_implementation::UseImplementation use_implementation)
+{
+    bench.name(strprintf("%s using the '%s' yespower implementation", name, YespowerAutoDetect(use_implementation)));
+    CBlockHeader header{CreateHeaders(1).front()};
+    bench.unit("hash").run([&] {
+        ++header.nNonce;
+        ankerl::nanobench::doNotOptimizeAway(header.GetPoWHash());
+    });
+    YespowerAutoDetect();
+}
+
+static void YESPOWER_STANDARD(benchmark::Bench& bench) { YespowerHash(bench, __func__, yespower_implementation::STANDARD); }
+static void YESPOWER_AVX2(benchmark::Bench& bench) { YespowerHash(bench, __func__, yespower_implementation::USE_AVX2); }
+static void YESPOWER_AVX512(benchmark::Bench& bench) { YespowerHash(bench, __func__, yespower_implementation::USE_AVX512); }
+
+// Hash a single header in a new region each time, so every hash allocates
+// and first touches its region, like the first hash on a new thread does.
+// Each region is freed after its hash. Compare with YespowerWarmRegion.
+static void YespowerColdRegion(benchmark::Bench& bench)
+{
+    CBlockHeader header{CreateHeaders(1).front()};
+    bench.minEpochIterations(10).unit("hash").run([&] {
+        ++header.nNonce;
+        yespower_local_t local;
+        int ret = yespower_init_local(&local);
+        assert(ret == 0);
+        ankerl::nanobench::doNotOptimizeAway(GetSerializedHeaderPoWHash(header.SerializeToArray(), &local));
+        yespower_free_local(&local);
+    });
+}
+
+// Hash a single header on the same thread each time, reusing its region.
+static void YespowerWarmRegion(benchmark::Bench& bench)
+{
+    CBlockHeader header{CreateHeaders(1).front()};
+    ankerl::nanobench::doNotOptimizeAway(header.GetPoWHash());
+    bench.unit("hash").run([&] {
+        ++header.nNonce;
+        ankerl::nanobench::doNotOptimizeAway(header.GetPoWHash());
+    });
+}
+
+// Hash headers in a region backed by regular or by huge pages
+// (-yespowerhugepages), to compare the cost of TLB misses on the header
+// verification path. Huge pages fall back to regular pages when the system
+// has none, in which case both report the same.
+static void HeadersPoWPages(benchmark::Bench& bench, bool use_hugepages)
+{
+    std::vector<CBlockHeader> headers{CreateHeaders(20)};
+    YespowerUseHugePages(use_hugepages);
+    // The region is allocated by its first hash, and freed at the end.
+    yespower_local_t local;
+    int ret = yespower_init_local(&local);
+    assert(ret == 0);
+    bench.batch(headers.size()).unit("header").run([&] {
+        for (CBlockHeader& header : headers) {
+            ++header.nNonce;
+            ankerl::nanobench::doNotOptimizeAway(GetSerializedHeaderPoWHash(header.SerializeToArray(), &local));
+        }
+    });
+    yespower_free_local(&local);
+    YespowerUseHugePages(false);
+}
+
+static void HeadersPoWSmallPages(benchmark::Bench& bench) { HeadersPoWPages(bench, false); }
+static void HeadersPoWHugePages(benchmark::Bench& bench) { HeadersPoWPages(bench, true); }
+
+// Verify the PoW of a full HEADERS message with the given total number of
+// threads (the calling thread plus threads - 1 workers).
+static void HeadersPoW(benchmark::Bench& bench, int threads)
+{
+    ArgsManager bench_args;
+    const auto chain_params{CreateChainParams(bench_args, ChainType::REGTEST)};
+    Consensus::Params consensus{chain_params->GetConsensus()};
+    consensus.powLimit = uint256S("ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+
+    std::vector<CBlockHeader> headers{CreateHeaders(HEADERS_BATCH_SIZE)};
+    if (threads > 1) StartHeaderPoWCheckWorkerThreads(threads - 1);
+
+    bench.batch(headers.size()).unit("header").run([&] {
+        // New nonces, so no PoW hash is memoized yet.
+        for (CBlockHeader& header : headers) ++header.nNonce;
+        bool valid = HasValidProofOfWork(headers, consensus);
+        assert(valid);
+    });
+
+    if (threads > 1) StopHeaderPoWCheckWorkerThreads();
+}
+
+static void HeadersPoW1Thread(benchmark::Bench& bench) { HeadersPoW(bench, 1); }
+static void HeadersPoW2Threads(benchmark::Bench& bench) { HeadersPoW(bench, 2); }
+static void HeadersPoW4Threads(benchmark::Bench& bench) { HeadersPoW(bench, 4); }
+static void HeadersPoW8Threads(benchmark::Bench& bench) { HeadersPoW(bench, 8); }
+
+BENCHMARK(YESPOWER_STANDARD, benchmark::PriorityLevel::HIGH);
+BENCHMARK(YESPOWER_AVX2, benchmark::PriorityLevel::HIGH);
+BENCHMARK(YESPOWER_AVX512, benchmark::PriorityLevel::HIGH);
+BENCHMARK(YespowerColdRegion, benchmark::PriorityLevel::HIGH);
+BENCHMARK(YespowerWarmRegion, benchmark::PriorityLevel::HIGH);
+BENCHMARK(HeadersPoWSmallPages, benchmark::PriorityLevel::HIGH);
+BENCHMARK(HeadersPoWHugePages, benchmark::PriorityLevel::HIGH);
+BENCHMARK(HeadersPoW1Thread, benchmark::PriorityLevel::LOW);
+BENCHMARK(HeadersPoW2Threads, benchmark::PriorityLevel::LOW);
+BENCHMARK(HeadersPoW4Threads, benchmark::PriorityLevel::LOW);
+BENCHMARK(HeadersPoW8Threads, benchmark::PriorityLevel::LOW);
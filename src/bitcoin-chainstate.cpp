@@ -291,6 +291,9 @@ epilogue:
     scheduler.stop();
     if (chainman.m_thread_load.joinable()) chainman.m_thread_load.join();
     StopScriptCheckWorkerThreads();
+    StopHeaderPoWCheckWorkerThreads();
+    StopBlockCheckWorkerThreads();
+    StopCoinsPrefetchWorkerThreads();
 
     GetMainSignals().FlushBackgroundCallbacks();
     {
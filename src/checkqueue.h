@@ -10,7 +10,14 @@
 #include <util/threadnames.h>
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 template <typename T>
@@ -25,11 +32,30 @@ class CCheckQueueControl;
   * onto the queue, where they are processed by N-1 worker threads. When
   * the master is done adding work, it temporarily joins the worker pool
   * as an N'th worker, until all jobs are done.
+  *
+  * Every worker has a queue of its own, which the master spreads the
+  * verifications over. A worker takes from the back of its own queue, and
+  * once that is empty steals from the front of the others, so that workers
+  * rarely contend for the same lock.
   */
 template <typename T>
 class CCheckQueue
 {
 private:
+    //! The verifications queued for one worker.
+    struct alignas(64) WorkerQueue {
+        Mutex m_mutex;
+        std::deque<T> checks GUARDED_BY(m_mutex);
+        //! Mirrors checks.size(), so that other workers skip empty queues without locking them.
+        std::atomic<size_t> size{0};
+    };
+
+    //! The per-worker queues. Only resized while there are no worker threads.
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+
+    //! The queue the master adds the next batch to. Only used by the master.
+    size_t m_next_queue{0};
+
     //! Mutex to protect the inner state
     Mutex m_mutex;
 
@@ -39,89 +65,103 @@ private:
     //! Master thread blocks on this when out of work
     std::condition_variable m_master_cv;
 
-    //! The queue of elements to be processed.
-    //! As the order of booleans doesn't matter, it is used as a LIFO (stack)
-    std::vector<T> queue GUARDED_BY(m_mutex);
+    //! The number of worker threads that are about to wait or waiting on m_worker_cv.
+    std::atomic<int> m_idle{0};
 
-    //! The number of workers (including the master) that are idle.
-    int nIdle GUARDED_BY(m_mutex){0};
-
-    //! The total number of workers (including the master).
-    int nTotal GUARDED_BY(m_mutex){0};
-
-    //! The temporary evaluation result.
-    bool fAllOk GUARDED_BY(m_mutex){true};
+    //! The number of elements in m_queues, not yet taken by any worker.
+    std::atomic<unsigned int> m_queued{0};
 
     /**
      * Number of verifications that haven't completed yet.
      * This includes elements that are no longer queued, but still in the
      * worker's own batches.
      */
-    unsigned int nTodo GUARDED_BY(m_mutex){0};
+    std::atomic<unsigned int> m_todo{0};
+
+    //! The temporary evaluation result.
+    std::atomic<bool> m_all_ok{true};
 
     //! The maximum number of elements to be processed in one batch
     const unsigned int nBatchSize;
 
+    //! Name prefix of the worker threads
+    const std::string m_thread_name;
+
     std::vector<std::thread> m_worker_threads;
     bool m_request_stop GUARDED_BY(m_mutex){false};
 
+    /**
+     * Move a batch of verifications to vChecks: from the back of queue index
+     * if it has any, otherwise from the front of the next non-empty queue.
+     * Returns false if all queues are empty.
+     */
+    bool TakeChecks(size_t index, std::vector<T>& vChecks)
+    {
+        if (m_queued.load() == 0) return false;
+        for (size_t i = 0; i < m_queues.size(); ++i) {
+            WorkerQueue& queue{*m_queues[(index + i) % m_queues.size()]};
+            if (queue.size.load(std::memory_order_relaxed) == 0) continue;
+            LOCK(queue.m_mutex);
+            if (queue.checks.empty()) continue;
+            // Do not take everything at once, but leave half of it so that
+            // whoever runs out of work next can steal some, and all workers
+            // finish approximately simultaneously.
+            const size_t nNow{std::max<size_t>(1, std::min<size_t>(nBatchSize, queue.checks.size() / 2))};
+            if (i == 0) {
+                auto start_it = queue.checks.end() - nNow;
+                vChecks.assign(std::make_move_iterator(start_it), std::make_move_iterator(queue.checks.end()));
+                queue.checks.erase(start_it, queue.checks.end());
+            } else {
+                auto end_it = queue.checks.begin() + nNow;
+                vChecks.assign(std::make_move_iterator(queue.checks.begin()), std::make_move_iterator(end_it));
+                queue.checks.erase(queue.checks.begin(), end_it);
+            }
+            queue.size.store(queue.checks.size(), std::memory_order_relaxed);
+            m_queued -= nNow;
+            return true;
+        }
+        return false;
+    }
+
     /** Internal function that does bulk of the verification work. */
-    bool Loop(bool fMaster) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    bool Loop(bool fMaster, size_t index) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
     {
-        std::condition_variable& cond = fMaster ? m_master_cv : m_worker_cv;
         std::vector<T> vChecks;
         vChecks.reserve(nBatchSize);
-        unsigned int nNow = 0;
-        bool fOk = true;
         do {
-            {
+            if (!TakeChecks(index, vChecks)) {
                 WAIT_LOCK(m_mutex, lock);
-                // first do the clean-up of the previous loop run (allowing us to do it in the same critsect)
-                if (nNow) {
-                    fAllOk &= fOk;
-                    nTodo -= nNow;
-                    if (nTodo == 0 && !fMaster)
-                        // We processed the last element; inform the master it can exit and return the result
-                        m_master_cv.notify_one();
+                if (fMaster) {
+                    // Even while the workers stop, the master only returns once every check
+                    // is done: it takes what they left queued, and waits for the batches
+                    // they are still running, which may write into results it returns to.
+                    m_master_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_todo == 0 || m_queued > 0; });
+                    if (m_todo == 0) {
+                        // return the current status, and reset it for new work later
+                        return m_all_ok.exchange(true);
+                    }
                 } else {
-                    // first iteration
-                    nTotal++;
-                }
-                // logically, the do loop starts here
-                while (queue.empty() && !m_request_stop) {
-                    if (fMaster && nTodo == 0) {
-                        nTotal--;
-                        bool fRet = fAllOk;
-                        // reset the status for new work later
-                        fAllOk = true;
-                        // return the current status
-                        return fRet;
+                    ++m_idle;
+                    m_worker_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_request_stop || m_queued > 0; });
+                    --m_idle;
+                    if (m_request_stop) {
+                        return false;
                     }
-                    nIdle++;
-                    cond.wait(lock); // wait
-                    nIdle--;
-                }
-                if (m_request_stop) {
-                    return false;
                 }
-
-                // Decide how many work units to process now.
-                // * Do not try to do everything at once, but aim for increasingly smaller batches so
-                //   all workers finish approximately simultaneously.
-                // * Try to account for idle jobs which will instantly start helping.
-                // * Don't do batches smaller than 1 (duh), or larger than nBatchSize.
-                nNow = std::max(1U, std::min(nBatchSize, (unsigned int)queue.size() / (nTotal + nIdle + 1)));
-                auto start_it = queue.end() - nNow;
-                vChecks.assign(std::make_move_iterator(start_it), std::make_move_iterator(queue.end()));
-                queue.erase(start_it, queue.end());
-                // Check whether we need to do work at all
-                fOk = fAllOk;
+                continue;
             }
-            // execute work
+            // execute work, unless another check failed already
+            bool fOk = m_all_ok.load(std::memory_order_relaxed);
             for (T& check : vChecks)
                 if (fOk)
                     fOk = check();
+            if (!fOk) m_all_ok = false;
+            const unsigned int nNow = vChecks.size();
             vChecks.clear();
+            if (m_todo.fetch_sub(nNow) == nNow && !fMaster) {
+                // We processed the last element; inform the master it can exit and return the result
+                WITH_LOCK(m_mutex, m_master_cv.notify_one());
+            }
         } while (true);
     }
 
@@ -130,25 +170,27 @@ public:
     Mutex m_control_mutex;
 
     //! Create a new check queue
-    explicit CCheckQueue(unsigned int nBatchSizeIn)
-        : nBatchSize(nBatchSizeIn)
+    explicit CCheckQueue(unsigned int nBatchSizeIn, std::string thread_name = "scriptch")
+        : nBatchSize(nBatchSizeIn), m_thread_name(std::move(thread_name))
     {
+        m_queues.push_back(std::make_unique<WorkerQueue>());
     }
 
     //! Create a pool of new worker threads.
     void StartWorkerThreads(const int threads_num) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
     {
-        {
-            LOCK(m_mutex);
-            nIdle = 0;
-            nTotal = 0;
-            fAllOk = true;
-        }
         assert(m_worker_threads.empty());
+        assert(m_queued == 0);
+        m_queues.clear();
+        for (int n = 0; n < std::max(threads_num, 1); ++n) {
+            m_queues.push_back(std::make_unique<WorkerQueue>());
+        }
+        m_next_queue = 0;
+        m_all_ok = true;
         for (int n = 0; n < threads_num; ++n) {
             m_worker_threads.emplace_back([this, n]() {
-                util::ThreadRename(strprintf("scriptch.%i", n));
-                Loop(false /* worker thread */);
+                util::ThreadRename(strprintf("%s.%i", m_thread_name, n));
+                Loop(false /* worker thread */, n);
             });
         }
     }
@@ -156,7 +198,7 @@ public:
     //! Wait until execution finishes, and return whether all evaluations were successful.
     bool Wait() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
     {
-        return Loop(true /* master thread */);
+        return Loop(true /* master thread */, m_next_queue);
     }
 
     //! Add a batch of checks to the queue
@@ -166,16 +208,31 @@ public:
             return;
         }
 
-        {
-            LOCK(m_mutex);
-            queue.insert(queue.end(), std::make_move_iterator(vChecks.begin()), std::make_move_iterator(vChecks.end()));
-            nTodo += vChecks.size();
+        // Spread the batch over the worker queues. Small batches, like the
+        // checks of a single transaction, go to one queue, and the next
+        // batch to the next one.
+        m_todo += vChecks.size();
+        const size_t per_queue{std::max<size_t>(nBatchSize, (vChecks.size() + m_queues.size() - 1) / m_queues.size())};
+        for (auto it = vChecks.begin(); it != vChecks.end();) {
+            const size_t nNow{std::min<size_t>(per_queue, vChecks.end() - it)};
+            WorkerQueue& queue{*m_queues[m_next_queue]};
+            m_next_queue = (m_next_queue + 1) % m_queues.size();
+            LOCK(queue.m_mutex);
+            queue.checks.insert(queue.checks.end(), std::make_move_iterator(it), std::make_move_iterator(it + nNow));
+            queue.size.store(queue.checks.size(), std::memory_order_relaxed);
+            m_queued += nNow;
+            it += nNow;
         }
 
-        if (vChecks.size() == 1) {
-            m_worker_cv.notify_one();
-        } else {
-            m_worker_cv.notify_all();
+        // Only take m_mutex if a worker may be waiting. A worker increments
+        // m_idle before it checks m_queued, so one of us sees the other.
+        if (m_idle > 0) {
+            LOCK(m_mutex);
+            if (vChecks.size() == 1) {
+                m_worker_cv.notify_one();
+            } else {
+                m_worker_cv.notify_all();
+            }
         }
     }
 
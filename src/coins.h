@@ -8,10 +8,10 @@
 
 #include <compressor.h>
 #include <core_memusage.h>
+#include <flathashmap.h>
 #include <memusage.h>
 #include <primitives/transaction.h>
 #include <serialize.h>
-#include <support/allocators/pool.h>
 #include <uint256.h>
 #include <util/hasher.h>
 
@@ -19,7 +19,6 @@
 #include <stdint.h>
 
 #include <functional>
-#include <unordered_map>
 
 /**
  * A UTXO entry.
@@ -133,21 +132,10 @@ struct CCoinsCacheEntry
 };
 
 /**
- * PoolAllocator's MAX_BLOCK_SIZE_BYTES parameter here uses sizeof the data, and adds the size
- * of 4 pointers. We do not know the exact node size used in the std::unordered_node implementation
- * because it is implementation defined. Most implementations have an overhead of 1 or 2 pointers,
- * so nodes can be connected in a linked list, and in some cases the hash value is stored as well.
- * Using an additional sizeof(void*)*4 for MAX_BLOCK_SIZE_BYTES should thus be sufficient so that
- * all implementations can allocate the nodes from the PoolAllocator.
+ * The entries of a coins cache. Inserting or erasing an entry invalidates
+ * references to all others, see FlatHashMap.
  */
-using CCoinsMap = std::unordered_map<COutPoint,
-                                     CCoinsCacheEntry,
-                                     SaltedOutpointHasher,
-                                     std::equal_to<COutPoint>,
-                                     PoolAllocator<std::pair<const COutPoint, CCoinsCacheEntry>,
-                                                   sizeof(std::pair<const COutPoint, CCoinsCacheEntry>) + sizeof(void*) * 4>>;
-
-using CCoinsMapMemoryResource = CCoinsMap::allocator_type::ResourceType;
+using CCoinsMap = FlatHashMap<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher>;
 
 /** Cursor for iterating over CoinsView state */
 class CCoinsViewCursor
@@ -236,12 +224,15 @@ protected:
      * declared as "const".
      */
     mutable uint256 hashBlock;
-    mutable CCoinsMapMemoryResource m_cache_coins_memory_resource{};
     mutable CCoinsMap cacheCoins;
 
     /* Cached dynamic memory usage for the inner Coin objects. */
     mutable size_t cachedCoinsUsage{0};
 
+    /* Number of coins read from the backing view, and of writes to it. */
+    mutable uint64_t m_base_reads{0};
+    uint64_t m_base_writes{0};
+
 public:
     CCoinsViewCache(CCoinsView *baseIn, bool deterministic = false);
 
@@ -272,10 +263,8 @@ public:
      * more efficient than GetCoin.
      *
      * Generally, do not hold the reference returned for more than a short scope.
-     * While the current implementation allows for modifications to the contents
-     * of the cache while holding the reference, this behavior should not be relied
-     * on! To be safe, best to not hold the returned reference through any other
-     * calls to this cache.
+     * Any call that adds coins to or removes them from the cache, including
+     * fetching another coin from the backing view, invalidates it.
      */
     const Coin& AccessCoin(const COutPoint &output) const;
 
@@ -294,6 +283,16 @@ public:
      */
     void EmplaceCoinInternalDANGER(COutPoint&& outpoint, Coin&& coin);
 
+    /**
+     * Add an unmodified coin read from the backing view, unless the cache has
+     * an entry for it already. Returns whether it was added.
+     *
+     * The coin must have been read since the last Flush() or Sync(), see
+     * GetBaseWrites(): writing to the backing view may have changed it.
+     * @sa ChainstateManager::PrefetchCoins()
+     */
+    bool WarmCoin(const COutPoint& outpoint, Coin&& coin);
+
     /**
      * Spend a coin. Pass moveto in order to get the deleted data.
      * If no unspent output exists for the passed outpoint, this call
@@ -330,14 +329,17 @@ public:
     //! Calculate the size of the cache (in bytes)
     size_t DynamicMemoryUsage() const;
 
+    //! The number of coins read from the backing view because they were not cached.
+    uint64_t GetBaseReads() const { return m_base_reads; }
+
+    //! The number of times the cache was written to the backing view.
+    uint64_t GetBaseWrites() const { return m_base_writes; }
+
     //! Check whether all prevouts of the transaction are present in the UTXO set represented by this view
     bool HaveInputs(const CTransaction& tx) const;
 
     //! Force a reallocation of the cache map. This is required when downsizing
-    //! the cache because the map's allocator may be hanging onto a lot of
-    //! memory despite having called .clear().
-    //!
-    //! See: https://stackoverflow.com/questions/42114044/how-to-release-unordered-map-memory
+    //! the cache because the map keeps its memory allocated when cleared.
     void ReallocateCache();
 
     //! Run an internal sanity check on the cache data structure. */
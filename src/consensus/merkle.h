@@ -18,6 +18,23 @@ uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool* mutated = nullptr);
  */
 uint256 BlockMerkleRoot(const CBlock& block, bool* mutated = nullptr);
 
+/*
+ * Compute the root of the subtree of height depth of the transaction Merkle
+ * tree of a block, which starts at transaction begin, a multiple of
+ * 2^depth. If the block has more than 2^depth transactions, the
+ * ComputeMerkleRoot() of the roots of all its subtrees is its Merkle root,
+ * and a duplicated subtree is found in either.
+ */
+uint256 BlockMerkleSubtreeRoot(const CBlock& block, size_t begin, unsigned int depth, bool* mutated = nullptr);
+
+/*
+ * Compute the Merkle branch of the transaction at position in a block: the
+ * hashes to combine its txid with, from the bottom of the tree up, to get the
+ * Merkle root. Miners use the branch of the coinbase to compute the Merkle
+ * root of a block after changing its coinbase.
+ */
+std::vector<uint256> BlockMerkleBranch(const CBlock& block, uint32_t position = 0);
+
 /*
  * Compute the Merkle root of the witness transactions in a block.
  * *mutated is set to true if a duplicated subtree was found.
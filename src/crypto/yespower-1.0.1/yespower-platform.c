@@ -30,6 +30,14 @@
 #undef HUGEPAGE_SIZE
 #endif
 
+/*
+ * Set by YespowerUseHugePages() (crypto/yespower.cpp), and read atomically as
+ * regions may be allocated by many threads at once. When non-zero, regions of
+ * at least one huge page are backed by explicit huge pages if any are
+ * reserved, else by transparent huge pages where the kernel supports them.
+ */
+extern int yespower_use_hugepages(void);
+
 static void *alloc_region(yespower_region_t *region, size_t size)
 {
 	size_t base_size = size;
@@ -41,9 +49,12 @@ static void *alloc_region(yespower_region_t *region, size_t size)
 #endif
 	    MAP_ANON | MAP_PRIVATE;
 #if defined(MAP_HUGETLB) && defined(HUGEPAGE_SIZE)
+	const int use_hugepages = yespower_use_hugepages();
 	size_t new_size = size;
 	const size_t hugepage_mask = (size_t)HUGEPAGE_SIZE - 1;
-	if (size >= HUGEPAGE_THRESHOLD && size + hugepage_mask >= size) {
+	const size_t hugepage_threshold = use_hugepages ?
+	    (size_t)HUGEPAGE_SIZE : (size_t)HUGEPAGE_THRESHOLD;
+	if (size >= hugepage_threshold && size + hugepage_mask >= size) {
 		flags |= MAP_HUGETLB;
 /*
  * Linux's munmap() fails on MAP_HUGETLB mappings if size is not a multiple of
@@ -53,19 +64,40 @@ static void *alloc_region(yespower_region_t *region, size_t size)
 		new_size &= ~hugepage_mask;
 	}
 	base = mmap(NULL, new_size, PROT_READ | PROT_WRITE, flags, -1, 0);
+	aligned = base;
 	if (base != MAP_FAILED) {
 		base_size = new_size;
 	} else if (flags & MAP_HUGETLB) {
 		flags &= ~MAP_HUGETLB;
-		base = mmap(NULL, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+#ifdef MADV_HUGEPAGE
+/*
+ * No explicit huge pages are reserved. Over-allocate so that the region can
+ * start on a huge page boundary, and ask for transparent huge pages instead.
+ */
+		if (use_hugepages && new_size + hugepage_mask >= new_size) {
+			base = mmap(NULL, new_size + hugepage_mask,
+			    PROT_READ | PROT_WRITE, flags, -1, 0);
+			if (base != MAP_FAILED) {
+				base_size = new_size + hugepage_mask;
+				aligned = base + hugepage_mask;
+				aligned -= (uintptr_t)aligned & hugepage_mask;
+				madvise(aligned, new_size, MADV_HUGEPAGE);
+			}
+		}
+		if (base == MAP_FAILED)
+#endif
+		{
+			base = mmap(NULL, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+			aligned = base;
+		}
 	}
 
 #else
 	base = mmap(NULL, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+	aligned = base;
 #endif
 	if (base == MAP_FAILED)
-		base = NULL;
-	aligned = base;
+		base = aligned = NULL;
 #elif defined(HAVE_POSIX_MEMALIGN)
 	if ((errno = posix_memalign((void **)&base, 64, size)) != 0)
 		base = NULL;
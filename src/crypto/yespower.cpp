@@ -0,0 +1,152 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#if defined(HAVE_CONFIG_H)
+#include <config/bitcoin-config.h>
+#endif
+
+#include <crypto/yespower.h>
+
+#include <compat/cpuid.h>
+
+#include <algorithm>
+#include <atomic>
+#include <assert.h>
+
+// The yespower core (crypto/yespower-1.0.1/yespower-opt.c) selects its SIMD
+// code at compile time, so it is built once per instruction set by the
+// crypto/yespower_*.c wrappers and the public yespower API below forwards to
+// the build chosen at runtime.
+extern "C" {
+int yespower_standard(yespower_local_t* local, const uint8_t* src, size_t srclen, const yespower_params_t* params, yespower_binary_t* dst);
+int yespower_tls_standard(const uint8_t* src, size_t srclen, const yespower_params_t* params, yespower_binary_t* dst);
+int yespower_init_local_standard(yespower_local_t* local);
+int yespower_free_local_standard(yespower_local_t* local);
+#if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
+int yespower_avx2(yespower_local_t* local, const uint8_t* src, size_t srclen, const yespower_params_t* params, yespower_binary_t* dst);
+int yespower_tls_avx2(const uint8_t* src, size_t srclen, const yespower_params_t* params, yespower_binary_t* dst);
+#endif
+#if defined(ENABLE_AVX512) && !defined(BUILD_BITCOIN_INTERNAL)
+int yespower_avx512(yespower_local_t* local, const uint8_t* src, size_t srclen, const yespower_params_t* params, yespower_binary_t* dst);
+int yespower_tls_avx512(const uint8_t* src, size_t srclen, const yespower_params_t* params, yespower_binary_t* dst);
+#endif
+}
+
+namespace {
+typedef int (*YespowerFn)(yespower_local_t*, const uint8_t*, size_t, const yespower_params_t*, yespower_binary_t*);
+typedef int (*YespowerTLSFn)(const uint8_t*, size_t, const yespower_params_t*, yespower_binary_t*);
+
+YespowerFn Yespower = yespower_standard;
+YespowerTLSFn YespowerTLS = yespower_tls_standard;
+
+/** Check whether the yespower implementation in use matches the yespower 1.0 test vector. */
+bool SelfTest()
+{
+    static const yespower_params_t params{YESPOWER_1_0, 2048, 32, nullptr, 0};
+    static const uint8_t expected[32] = {
+        0xd5, 0xef, 0xb8, 0x13, 0xcd, 0x26, 0x3e, 0x9b, 0x34, 0x54, 0x01, 0x30, 0x23, 0x3c, 0xbb, 0xc6,
+        0xa9, 0x21, 0xfb, 0xff, 0x34, 0x31, 0xe5, 0xec, 0x1a, 0x1a, 0xbd, 0xe2, 0xae, 0xa6, 0xff, 0x4d,
+    };
+    uint8_t src[80];
+    for (size_t i = 0; i < sizeof(src); ++i) src[i] = i * 3;
+    yespower_binary_t dst;
+    if (YespowerTLS(src, sizeof(src), &params, &dst)) return false;
+    return std::equal(dst.uc, dst.uc + sizeof(dst.uc), expected);
+}
+
+#if defined(USE_ASM) && defined(HAVE_GETCPUID) && !defined(BUILD_BITCOIN_INTERNAL)
+/** Return the XCR0 register, which tells which register states the OS saves. */
+uint64_t GetXCR0()
+{
+    uint32_t a, d;
+    __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    return (uint64_t{d} << 32) | a;
+}
+#endif
+} // namespace
+
+static std::atomic<bool> g_yespower_use_hugepages{false};
+
+extern "C" {
+// Called by alloc_region() in crypto/yespower-1.0.1/yespower-platform.c.
+int yespower_use_hugepages(void)
+{
+    return g_yespower_use_hugepages.load(std::memory_order_relaxed);
+}
+
+int yespower(yespower_local_t* local, const uint8_t* src, size_t srclen, const yespower_params_t* params, yespower_binary_t* dst)
+{
+    return Yespower(local, src, srclen, params, dst);
+}
+
+int yespower_tls(const uint8_t* src, size_t srclen, const yespower_params_t* params, yespower_binary_t* dst)
+{
+    return YespowerTLS(src, srclen, params, dst);
+}
+
+int yespower_init_local(yespower_local_t* local)
+{
+    return yespower_init_local_standard(local);
+}
+
+int yespower_free_local(yespower_local_t* local)
+{
+    return yespower_free_local_standard(local);
+}
+}
+
+std::string YespowerAutoDetect(yespower_implementation::UseImplementation use_implementation)
+{
+    std::string ret = "standard";
+    Yespower = yespower_standard;
+    YespowerTLS = yespower_tls_standard;
+
+#if defined(USE_ASM) && defined(HAVE_GETCPUID) && !defined(BUILD_BITCOIN_INTERNAL)
+    [[maybe_unused]] bool have_avx2 = false;
+    [[maybe_unused]] bool have_avx512 = false;
+
+    uint32_t eax, ebx, ecx, edx;
+    GetCPUID(1, 0, eax, ebx, ecx, edx);
+    const bool have_xsave = (ecx >> 27) & 1;
+    const bool have_avx = (ecx >> 28) & 1;
+    if (have_xsave && have_avx) {
+        const uint64_t xcr0 = GetXCR0();
+        const bool enabled_avx = (xcr0 & 0x6) == 0x6;
+        // AVX-512 additionally needs the opmask and upper ZMM register states.
+        const bool enabled_avx512 = (xcr0 & 0xe6) == 0xe6;
+        GetCPUID(7, 0, eax, ebx, ecx, edx);
+        if (enabled_avx && (use_implementation & yespower_implementation::USE_AVX2)) {
+            have_avx2 = (ebx >> 5) & 1;
+        }
+        if (enabled_avx512 && (use_implementation & yespower_implementation::USE_AVX512)) {
+            // AVX512F and AVX512VL
+            have_avx512 = ((ebx >> 16) & 1) && ((ebx >> 31) & 1);
+        }
+    }
+
+#if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
+    if (have_avx2) {
+        Yespower = yespower_avx2;
+        YespowerTLS = yespower_tls_avx2;
+        ret = "avx2";
+    }
+#endif
+
+#if defined(ENABLE_AVX512) && !defined(BUILD_BITCOIN_INTERNAL)
+    if (have_avx512) {
+        Yespower = yespower_avx512;
+        YespowerTLS = yespower_tls_avx512;
+        ret = "avx512";
+    }
+#endif
+#endif // defined(USE_ASM) && defined(HAVE_GETCPUID) && !defined(BUILD_BITCOIN_INTERNAL)
+
+    assert(SelfTest());
+    return ret;
+}
+
+void YespowerUseHugePages(bool use_hugepages)
+{
+    g_yespower_use_hugepages = use_hugepages;
+}
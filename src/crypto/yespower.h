@@ -0,0 +1,37 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CRYPTO_YESPOWER_H
+#define BITCOIN_CRYPTO_YESPOWER_H
+
+#include <crypto/yespower-1.0.1/yespower.h> // IWYU pragma: export
+
+#include <stdint.h>
+#include <string>
+
+namespace yespower_implementation {
+enum UseImplementation : uint8_t {
+    STANDARD = 0,
+    USE_AVX2 = 1 << 0,
+    USE_AVX512 = 1 << 1,
+    USE_ALL = USE_AVX2 | USE_AVX512,
+};
+}
+
+/** Autodetect the best available yespower implementation and route
+ *  yespower() and yespower_tls() to it.
+ *  Returns the name of the implementation.
+ */
+std::string YespowerAutoDetect(yespower_implementation::UseImplementation use_implementation = yespower_implementation::USE_ALL);
+
+/** Back the scratch regions of yespower computations with 2 MiB huge pages:
+ *  explicit huge pages when the system has any reserved, transparent huge
+ *  pages otherwise. Falls back to regular pages when neither is available.
+ *  Only affects regions allocated afterwards; each thread allocates its
+ *  yespower_tls() region on its first hash. May be called while other
+ *  threads are hashing.
+ */
+void YespowerUseHugePages(bool use_hugepages);
+
+#endif // BITCOIN_CRYPTO_YESPOWER_H
@@ -0,0 +1,17 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+// Build of the yespower core compiled for AVX2, selected at runtime by
+// YespowerAutoDetect().
+
+#ifdef ENABLE_AVX2
+
+#define yespower yespower_avx2
+#define yespower_tls yespower_tls_avx2
+#define yespower_init_local yespower_init_local_avx2
+#define yespower_free_local yespower_free_local_avx2
+
+#include "yespower-1.0.1/yespower-opt.c"
+
+#endif
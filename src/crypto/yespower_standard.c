@@ -0,0 +1,14 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+// Baseline build of the yespower core, using whatever instruction set the
+// compiler targets by default (SSE2 on x86_64). Always available as the fallback
+// of YespowerAutoDetect().
+
+#define yespower yespower_standard
+#define yespower_tls yespower_tls_standard
+#define yespower_init_local yespower_init_local_standard
+#define yespower_free_local yespower_free_local_standard
+
+#include "yespower-1.0.1/yespower-opt.c"
@@ -0,0 +1,323 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_FLATHASHMAP_H
+#define BITCOIN_FLATHASHMAP_H
+
+#include <crypto/common.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * Hash map with open addressing, for large maps of small entries that are
+ * looked up far more often than they are iterated over, like the coins cache.
+ *
+ * The entries are stored densely in chunks that are never moved or resized,
+ * and found through a power-of-two table of 64-bit slots that is probed
+ * linearly. A slot holds the upper half of its entry's hash and the entry's
+ * position, so a lookup reads one slot and, unless the hashes differ, the one
+ * entry, instead of chasing the node pointers of std::unordered_map.
+ *
+ * Unlike std::unordered_map, inserting or erasing an entry invalidates all
+ * iterators and references to entries. erase(it) does return an iterator to
+ * the entry to continue iterating with: erasing moves the last entry into the
+ * erased entry's place, and iteration is over positions in insertion order.
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual = std::equal_to<K>>
+class FlatHashMap
+{
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<const K, V>;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using size_type = size_t;
+
+    //! Entries per chunk. The first chunks double in size, so that small maps
+    //! stay small, up to the size of all further chunks.
+    static constexpr size_t MIN_CHUNK_ENTRIES{16};
+    static constexpr size_t MAX_CHUNK_ENTRIES{1024};
+    static constexpr size_t GROWING_CHUNKS{6};
+    static_assert(MIN_CHUNK_ENTRIES << GROWING_CHUNKS == MAX_CHUNK_ENTRIES);
+    static constexpr size_t ChunkEntries(size_t chunk)
+    {
+        return chunk < GROWING_CHUNKS ? MIN_CHUNK_ENTRIES << chunk : MAX_CHUNK_ENTRIES;
+    }
+
+    template <bool IsConst>
+    class Iterator
+    {
+        using Map = std::conditional_t<IsConst, const FlatHashMap, FlatHashMap>;
+        Map* m_map{nullptr};
+        size_t m_pos{0};
+
+        Iterator(Map* map, size_t pos) : m_map{map}, m_pos{pos} {}
+        friend class FlatHashMap;
+        friend class Iterator<!IsConst>;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = FlatHashMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
+        using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
+
+        Iterator() = default;
+        template <bool C = IsConst, std::enable_if_t<!C, int> = 0>
+        operator Iterator<true>() const { return {m_map, m_pos}; }
+
+        reference operator*() const { return m_map->Entry(m_pos); }
+        pointer operator->() const { return &m_map->Entry(m_pos); }
+        Iterator& operator++() { ++m_pos; return *this; }
+        Iterator operator++(int) { Iterator ret{*this}; ++m_pos; return ret; }
+        friend bool operator==(const Iterator& a, const Iterator& b) { return a.m_pos == b.m_pos; }
+        friend bool operator!=(const Iterator& a, const Iterator& b) { return a.m_pos != b.m_pos; }
+    };
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    explicit FlatHashMap(const Hash& hash = Hash{}, const KeyEqual& key_equal = KeyEqual{})
+        : m_hash{hash}, m_key_equal{key_equal} {}
+
+    FlatHashMap(const FlatHashMap&) = delete;
+    FlatHashMap& operator=(const FlatHashMap&) = delete;
+
+    FlatHashMap(FlatHashMap&& other) noexcept
+        : m_hash{other.m_hash}, m_key_equal{other.m_key_equal}
+    {
+        Swap(other);
+    }
+
+    //! Hashers may not be assignable (SaltedOutpointHasher's salt is const),
+    //! so this replaces the whole map.
+    FlatHashMap& operator=(FlatHashMap&& other) noexcept
+    {
+        if (this != &other) {
+            this->~FlatHashMap();
+            ::new (this) FlatHashMap(std::move(other));
+        }
+        return *this;
+    }
+
+    ~FlatHashMap()
+    {
+        clear();
+        for (size_t chunk = 0; chunk < m_chunks.size(); ++chunk) {
+            std::allocator<value_type>{}.deallocate(m_chunks[chunk], ChunkEntries(chunk));
+        }
+    }
+
+    iterator begin() { return {this, 0}; }
+    iterator end() { return {this, m_size}; }
+    const_iterator begin() const { return {this, 0}; }
+    const_iterator end() const { return {this, m_size}; }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    iterator find(const K& key)
+    {
+        const size_t slot{FindSlot(key, m_hash(key))};
+        return slot == NOT_FOUND ? end() : iterator{this, SlotPos(m_slots[slot])};
+    }
+
+    const_iterator find(const K& key) const
+    {
+        const size_t slot{FindSlot(key, m_hash(key))};
+        return slot == NOT_FOUND ? end() : const_iterator{this, SlotPos(m_slots[slot])};
+    }
+
+    size_t count(const K& key) const { return find(key) != end(); }
+
+    /** Insert an entry constructed from args unless there is one for key already. */
+    template <typename KArg, typename... Args>
+    std::pair<iterator, bool> try_emplace(KArg&& key, Args&&... args)
+    {
+        const uint64_t hash{m_hash(key)};
+        if (const size_t slot{FindSlot(key, hash)}; slot != NOT_FOUND) {
+            return {iterator{this, SlotPos(m_slots[slot])}, false};
+        }
+        if ((m_size + m_deleted + 1) * 8 > m_slots.size() * 7) Rehash(m_size + 1);
+
+        const size_t pos{m_size};
+        if (pos == m_capacity) {
+            m_chunks.push_back(std::allocator<value_type>{}.allocate(ChunkEntries(m_chunks.size())));
+            m_capacity += ChunkEntries(m_chunks.size() - 1);
+        }
+        ::new (&Entry(pos)) value_type(std::piecewise_construct,
+                                       std::forward_as_tuple(std::forward<KArg>(key)),
+                                       std::forward_as_tuple(std::forward<Args>(args)...));
+        ++m_size;
+
+        const size_t mask{m_slots.size() - 1};
+        size_t slot{hash & mask};
+        while (SlotPos(m_slots[slot]) < DELETED_POS) slot = (slot + 1) & mask;
+        if (SlotPos(m_slots[slot]) == DELETED_POS) --m_deleted;
+        m_slots[slot] = MakeSlot(hash, pos);
+        return {iterator{this, pos}, true};
+    }
+
+    template <typename KArg, typename VArg>
+    std::pair<iterator, bool> emplace(KArg&& key, VArg&& value)
+    {
+        return try_emplace(std::forward<KArg>(key), std::forward<VArg>(value));
+    }
+
+    template <typename... KArgs, typename... VArgs>
+    std::pair<iterator, bool> emplace(std::piecewise_construct_t, std::tuple<KArgs...> key_args, std::tuple<VArgs...> value_args)
+    {
+        K key{std::make_from_tuple<K>(std::move(key_args))};
+        return std::apply([&](auto&&... args) {
+            return try_emplace(std::move(key), std::forward<decltype(args)>(args)...);
+        }, std::move(value_args));
+    }
+
+    V& operator[](const K& key) { return try_emplace(key).first->second; }
+
+    /** Erase an entry, returning an iterator to the one that takes its place. */
+    iterator erase(const_iterator it)
+    {
+        const size_t pos{it.m_pos};
+        assert(pos < m_size);
+        value_type& entry{Entry(pos)};
+        m_slots[PosSlot(pos, m_hash(entry.first))] = DELETED_SLOT;
+        ++m_deleted;
+        const size_t last{m_size - 1};
+        if (pos != last) {
+            value_type& last_entry{Entry(last)};
+            uint64_t& last_slot{m_slots[PosSlot(last, m_hash(last_entry.first))]};
+            last_slot = MakeSlot(last_slot, pos);
+            entry.~value_type();
+            ::new (&entry) value_type(std::move(last_entry));
+        }
+        Entry(last).~value_type();
+        --m_size;
+        return {this, pos};
+    }
+
+    size_t erase(const K& key)
+    {
+        const auto it{find(key)};
+        if (it == end()) return 0;
+        erase(it);
+        return 1;
+    }
+
+    /** Erase all entries, keeping the memory allocated for them. */
+    void clear()
+    {
+        for (size_t pos = 0; pos < m_size; ++pos) {
+            Entry(pos).~value_type();
+        }
+        m_size = 0;
+        m_deleted = 0;
+        std::fill(m_slots.begin(), m_slots.end(), EMPTY_SLOT);
+    }
+
+    /** Make room for count entries without growing the slot table. */
+    void reserve(size_t count)
+    {
+        if (count * 8 > m_slots.size() * 7) Rehash(count);
+    }
+
+    //! Memory usage details, see memusage::DynamicUsage.
+    size_t SlotCount() const { return m_slots.capacity(); }
+    size_t ChunkCount() const { return m_chunks.size(); }
+    size_t ChunkPointerCapacity() const { return m_chunks.capacity(); }
+
+private:
+    //! A slot is the upper half of its entry's hash and the entry's position.
+    //! Unused slots and those of erased entries have these positions.
+    static constexpr uint32_t EMPTY_POS{0xffffffff};
+    static constexpr uint32_t DELETED_POS{0xfffffffe};
+    static constexpr uint64_t EMPTY_SLOT{EMPTY_POS};
+    static constexpr uint64_t DELETED_SLOT{DELETED_POS};
+    static constexpr size_t NOT_FOUND{~size_t{0}};
+
+    static uint32_t SlotPos(uint64_t slot) { return static_cast<uint32_t>(slot); }
+    static uint64_t MakeSlot(uint64_t hash, size_t pos) { return (hash & 0xffffffff00000000) | pos; }
+
+    Hash m_hash;
+    KeyEqual m_key_equal;
+    std::vector<uint64_t> m_slots;
+    std::vector<value_type*> m_chunks;
+    size_t m_capacity{0};
+    size_t m_size{0};
+    size_t m_deleted{0};
+
+    value_type& Entry(size_t pos) const
+    {
+        constexpr size_t GROWN_ENTRIES{MIN_CHUNK_ENTRIES * ((size_t{1} << GROWING_CHUNKS) - 1)};
+        if (pos < GROWN_ENTRIES) {
+            const size_t chunk{CountBits(pos / MIN_CHUNK_ENTRIES + 1) - 1};
+            return m_chunks[chunk][pos - MIN_CHUNK_ENTRIES * ((size_t{1} << chunk) - 1)];
+        }
+        pos -= GROWN_ENTRIES;
+        return m_chunks[GROWING_CHUNKS + pos / MAX_CHUNK_ENTRIES][pos % MAX_CHUNK_ENTRIES];
+    }
+
+    size_t FindSlot(const K& key, uint64_t hash) const
+    {
+        if (m_slots.empty()) return NOT_FOUND;
+        const size_t mask{m_slots.size() - 1};
+        for (size_t slot{hash & mask};; slot = (slot + 1) & mask) {
+            const uint64_t value{m_slots[slot]};
+            const uint32_t pos{SlotPos(value)};
+            if (pos == EMPTY_POS) return NOT_FOUND;
+            if (pos != DELETED_POS && (value >> 32) == (hash >> 32) && m_key_equal(Entry(pos).first, key)) return slot;
+        }
+    }
+
+    //! The slot of the entry at pos, which has the given hash.
+    size_t PosSlot(size_t pos, uint64_t hash) const
+    {
+        const size_t mask{m_slots.size() - 1};
+        size_t slot{hash & mask};
+        while (SlotPos(m_slots[slot]) != pos) slot = (slot + 1) & mask;
+        return slot;
+    }
+
+    //! Rebuild the slot table, dropping erased entries' slots, large enough
+    //! for count entries.
+    void Rehash(size_t count)
+    {
+        size_t slot_count{std::max<size_t>(m_slots.size(), 16)};
+        // Grow to twice what is needed, so that the next rehash is a while off.
+        while (count * 16 > slot_count * 7) slot_count *= 2;
+        std::vector<uint64_t> slots(slot_count, EMPTY_SLOT);
+        const size_t mask{slot_count - 1};
+        for (size_t pos = 0; pos < m_size; ++pos) {
+            const uint64_t hash{m_hash(Entry(pos).first)};
+            size_t slot{hash & mask};
+            while (slots[slot] != EMPTY_SLOT) slot = (slot + 1) & mask;
+            slots[slot] = MakeSlot(hash, pos);
+        }
+        m_slots = std::move(slots);
+        m_deleted = 0;
+    }
+
+    //! Swap the entries, but not the hashers, with other.
+    void Swap(FlatHashMap& other) noexcept
+    {
+        m_slots.swap(other.m_slots);
+        m_chunks.swap(other.m_chunks);
+        std::swap(m_capacity, other.m_capacity);
+        std::swap(m_size, other.m_size);
+        std::swap(m_deleted, other.m_deleted);
+    }
+};
+
+#endif // BITCOIN_FLATHASHMAP_H
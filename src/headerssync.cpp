@@ -9,24 +9,24 @@
 #include <util/check.h>
 #include <util/vector.h>
 
-// The two constants below are computed using the simulation script in
-// contrib/devtools/headerssync-params.py.
+#include <algorithm>
 
-//! Store one header commitment per HEADER_COMMITMENT_PERIOD blocks.
-constexpr size_t HEADER_COMMITMENT_PERIOD{6060};
-
-//! Only feed headers to validation once this many headers on top have been
-//! received and validated against commitments.
-constexpr size_t REDOWNLOAD_BUFFER_SIZE{144410}; // 14441/606 = ~23.8 commitments
+//! Remember the hash of one in this many headers whose proof of work was
+//! checked during PRESYNC, so that it is not checked again for them and the
+//! headers before them when they are redownloaded.
+constexpr int64_t PRESYNC_POW_CHECKED_PERIOD{64};
+//! Maximum number of those hashes (32 bytes each), covering 2^20 headers.
+constexpr size_t PRESYNC_POW_CHECKED_MAX_HASHES{1 << 14};
 
 // Our memory analysis assumes 48 bytes for a CompressedHeader (so we should
 // re-calculate parameters if we compress further)
 static_assert(sizeof(CompressedHeader) == 48);
 
 HeadersSyncState::HeadersSyncState(NodeId id, const Consensus::Params& consensus_params,
-        const CBlockIndex* chain_start, const arith_uint256& minimum_required_work) :
-    m_commit_offset(GetRand<unsigned>(HEADER_COMMITMENT_PERIOD)),
-    m_id(id), m_consensus_params(consensus_params),
+        const HeadersSyncParams& params, const CBlockIndex* chain_start,
+        const arith_uint256& minimum_required_work) :
+    m_commit_offset(GetRand<unsigned>(params.commitment_period)),
+    m_id(id), m_consensus_params(consensus_params), m_params(params),
     m_chain_start(chain_start),
     m_minimum_required_work(minimum_required_work),
     m_current_chain_work(chain_start->nChainWork),
@@ -41,7 +41,7 @@ HeadersSyncState::HeadersSyncState(NodeId id, const Consensus::Params& consensus
     // exceeds this bound, because it's not possible for a consensus-valid
     // chain to be longer than this (at the current time -- in the future we
     // could try again, if necessary, to sync a longer chain).
-    m_max_commitments = 6*(Ticks<std::chrono::seconds>(GetAdjustedTime() - NodeSeconds{std::chrono::seconds{chain_start->GetMedianTimePast()}}) + MAX_FUTURE_BLOCK_TIME) / HEADER_COMMITMENT_PERIOD;
+    m_max_commitments = 6*(Ticks<std::chrono::seconds>(GetAdjustedTime() - NodeSeconds{std::chrono::seconds{chain_start->GetMedianTimePast()}}) + MAX_FUTURE_BLOCK_TIME) / m_params.commitment_period;
 
     LogPrint(BCLog::NET, "Initial headers sync started with peer=%d: height=%i, max_commitments=%i, min_work=%s\n", m_id, m_current_height, m_max_commitments, m_minimum_required_work.ToString());
 }
@@ -53,6 +53,7 @@ void HeadersSyncState::Finalize()
 {
     Assume(m_download_state != State::FINAL);
     ClearShrink(m_header_commitments);
+    ClearShrink(m_presync_pow_checked);
     m_last_header_received.SetNull();
     ClearShrink(m_redownloaded_headers);
     m_redownload_buffer_last_hash.SetNull();
@@ -113,8 +114,11 @@ HeadersSyncState::ProcessingResult HeadersSyncState::ProcessNextHeaders(const
         }
 
         if (ret.success) {
-            // Return any headers that are ready for acceptance.
+            // Return any headers that are ready for acceptance, and tell which
+            // of them had their proof of work checked during PRESYNC.
+            const int64_t first_height{m_redownload_buffer_last_height - static_cast<int64_t>(m_redownloaded_headers.size()) + 1};
             ret.pow_validated_headers = PopHeadersReadyForAcceptance();
+            ret.presync_pow_checked = std::clamp<int64_t>(m_redownload_pow_checked_height - first_height + 1, 0, ret.pow_validated_headers.size());
 
             // If we hit our target blockhash, then all remaining headers will be
             // returned and we can clear any leftover internal state.
@@ -193,7 +197,7 @@ bool HeadersSyncState::ValidateAndProcessSingleHeader(const CBlockHeader& curren
         return false;
     }
 
-    if (next_height % HEADER_COMMITMENT_PERIOD == m_commit_offset) {
+    if (next_height % m_params.commitment_period == m_commit_offset) {
         // Add a commitment.
         m_header_commitments.push_back(m_hasher(current.GetHash()) & 1);
         if (m_header_commitments.size() > m_max_commitments) {
@@ -206,6 +210,10 @@ bool HeadersSyncState::ValidateAndProcessSingleHeader(const CBlockHeader& curren
         }
     }
 
+    if (IsPresyncPoWCheckedHeight(next_height) && m_presync_pow_checked.size() < PRESYNC_POW_CHECKED_MAX_HASHES) {
+        m_presync_pow_checked.push_back(current.GetHash());
+    }
+
     m_current_chain_work += GetBlockProof(CBlockIndex(current));
     m_last_header_received = current;
     m_current_height = next_height;
@@ -254,7 +262,7 @@ bool HeadersSyncState::ValidateAndStoreRedownloadedHeader(const CBlockHeader& he
     // it's possible our peer has extended its chain between our first sync and
     // our second, and we don't want to return failure after we've seen our
     // target blockhash just because we ran out of commitments.
-    if (!m_process_all_remaining_headers && next_height % HEADER_COMMITMENT_PERIOD == m_commit_offset) {
+    if (!m_process_all_remaining_headers && next_height % m_params.commitment_period == m_commit_offset) {
         if (m_header_commitments.size() == 0) {
             LogPrint(BCLog::NET, "Initial headers sync aborted with peer=%d: commitment overrun at height=%i (redownload phase)\n", m_id, next_height);
             // Somehow our peer managed to feed us a different chain and
@@ -270,6 +278,18 @@ bool HeadersSyncState::ValidateAndStoreRedownloadedHeader(const CBlockHeader& he
         }
     }
 
+    // Keep the front of m_presync_pow_checked at the next height that has one.
+    if (IsPresyncPoWCheckedHeight(next_height) && !m_presync_pow_checked.empty()) {
+        if (header.GetHash() == m_presync_pow_checked.front()) {
+            m_redownload_pow_checked_height = next_height;
+            m_presync_pow_checked.pop_front();
+        } else {
+            // The chain differs from the one received during PRESYNC, so no
+            // later header matches either.
+            ClearShrink(m_presync_pow_checked);
+        }
+    }
+
     // Store this header for later processing.
     m_redownloaded_headers.emplace_back(header);
     m_redownload_buffer_last_height = next_height;
@@ -285,7 +305,7 @@ std::vector<CBlockHeader> HeadersSyncState::PopHeadersReadyForAcceptance()
     Assume(m_download_state == State::REDOWNLOAD);
     if (m_download_state != State::REDOWNLOAD) return ret;
 
-    while (m_redownloaded_headers.size() > REDOWNLOAD_BUFFER_SIZE ||
+    while (m_redownloaded_headers.size() > m_params.redownload_buffer_size ||
             (m_redownloaded_headers.size() > 0 && m_process_all_remaining_headers)) {
         ret.emplace_back(m_redownloaded_headers.front().GetFullHeader(m_redownload_buffer_first_prev_hash));
         m_redownloaded_headers.pop_front();
@@ -294,6 +314,30 @@ std::vector<CBlockHeader> HeadersSyncState::PopHeadersReadyForAcceptance()
     return ret;
 }
 
+bool HeadersSyncState::IsPresyncPoWCheckedHeight(int64_t height) const
+{
+    return (height - m_chain_start->nHeight) % PRESYNC_POW_CHECKED_PERIOD == 0;
+}
+
+size_t HeadersSyncState::CountPresyncCheckedHeaders(const std::vector<CBlockHeader>& headers) const
+{
+    if (m_download_state != State::REDOWNLOAD) return 0;
+
+    uint256 prev_hash{m_redownload_buffer_last_hash};
+    int64_t height{m_redownload_buffer_last_height};
+    size_t next_hash{0};
+    size_t count{0};
+    for (size_t i = 0; i < headers.size() && next_hash < m_presync_pow_checked.size(); ++i) {
+        // Hashes are stored by height, so the headers must connect.
+        if (headers[i].hashPrevBlock != prev_hash) break;
+        prev_hash = headers[i].GetHash();
+        if (!IsPresyncPoWCheckedHeight(++height)) continue;
+        if (prev_hash != m_presync_pow_checked[next_hash++]) break;
+        count = i + 1;
+    }
+    return count;
+}
+
 CBlockLocator HeadersSyncState::NextHeadersRequestLocator() const
 {
     Assume(m_download_state != State::FINAL);
@@ -8,6 +8,7 @@
 #include <arith_uint256.h>
 #include <chain.h>
 #include <consensus/params.h>
+#include <kernel/chainparams.h>
 #include <net.h> // For NodeId
 #include <primitives/block.h>
 #include <uint256.h>
@@ -132,15 +133,18 @@ public:
      *
      * id: node id (for logging)
      * consensus_params: parameters needed for difficulty adjustment validation
+     * params: commitment period and redownload buffer size for this chain
      * chain_start: best known fork point that the peer's headers branch from
      * minimum_required_work: amount of chain work required to accept the chain
      */
     HeadersSyncState(NodeId id, const Consensus::Params& consensus_params,
-            const CBlockIndex* chain_start, const arith_uint256& minimum_required_work);
+            const HeadersSyncParams& params, const CBlockIndex* chain_start,
+            const arith_uint256& minimum_required_work);
 
     /** Result data structure for ProcessNextHeaders. */
     struct ProcessingResult {
         std::vector<CBlockHeader> pow_validated_headers;
+        size_t presync_pow_checked{0};
         bool success{false};
         bool request_more{false};
     };
@@ -160,6 +164,10 @@ public:
      *                       headers that the caller can fully process and
      *                       validate now (because these returned headers are
      *                       on a chain with sufficient work)
+     * ProcessingResult.presync_pow_checked: how many of pow_validated_headers,
+     *                       from the front, are known to be the headers
+     *                       received during PRESYNC, whose proof of work the
+     *                       caller checked back then
      * ProcessingResult.success: set to false if an error is detected and the sync is
      *                       aborted; true otherwise.
      * ProcessingResult.request_more: if true, the caller is suggested to call
@@ -175,11 +183,22 @@ public:
      */
     CBlockLocator NextHeadersRequestLocator() const;
 
+    /** In REDOWNLOAD, return how many headers at the front of the given ones
+     * continue the redownloaded chain with headers whose proof of work was
+     * already checked by the caller during PRESYNC, so that it need not be
+     * checked again.
+     *
+     * These are the headers up to the last one whose hash matches a hash
+     * stored during PRESYNC: as every header commits to the hash of the one
+     * before it, the headers leading up to it are the same as well.
+     */
+    size_t CountPresyncCheckedHeaders(const std::vector<CBlockHeader>& headers) const;
+
 protected:
     /** The (secret) offset on the heights for which to create commitments.
      *
      * m_header_commitments entries are created at any height h for which
-     * (h % HEADER_COMMITMENT_PERIOD) == m_commit_offset. */
+     * (h % m_params.commitment_period) == m_commit_offset. */
     const unsigned m_commit_offset;
 
 private:
@@ -214,6 +233,9 @@ private:
     /** We use the consensus params in our anti-DoS calculations */
     const Consensus::Params& m_consensus_params;
 
+    /** Commitment period and redownload buffer size in use for this sync. */
+    const HeadersSyncParams m_params;
+
     /** Store the last block in our block index that the peer's chain builds from */
     const CBlockIndex* m_chain_start{nullptr};
 
@@ -229,6 +251,21 @@ private:
     /** A queue of commitment bits, created during the 1st phase, and verified during the 2nd. */
     bitdeque<> m_header_commitments;
 
+    /** Hashes of the headers received during PRESYNC, whose proof of work
+     * the caller checked, at every PRESYNC_POW_CHECKED_PERIOD heights above
+     * m_chain_start, for at most PRESYNC_POW_CHECKED_MAX_HASHES of them.
+     * During REDOWNLOAD the front entry is for the next such height to be
+     * redownloaded. */
+    std::deque<uint256> m_presync_pow_checked;
+
+    /** Whether a header at this height has its hash in m_presync_pow_checked. */
+    bool IsPresyncPoWCheckedHeight(int64_t height) const;
+
+    /** Height of the last redownloaded header whose hash matched one in
+     * m_presync_pow_checked, so that it and the headers before it are the
+     * ones received during PRESYNC. */
+    int64_t m_redownload_pow_checked_height{0};
+
     /** m_max_commitments is a bound we calculate on how long an honest peer's chain could be,
      * given the MTP rule.
      *
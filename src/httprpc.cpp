@@ -175,6 +175,8 @@ static bool HTTPReq_JSONRPC(const std::any& context, HTTPRequest* req)
         return false;
     }
 
+    // Whether the handler took over the reply
+    bool deferred{false};
     try {
         // Parse request
         UniValue valRequest;
@@ -199,7 +201,31 @@ static bool HTTPReq_JSONRPC(const std::any& context, HTTPRequest* req)
                 req->WriteReply(HTTP_FORBIDDEN);
                 return false;
             }
+            // Let handlers waiting for an event, like getblocktemplate
+            // longpolls, release this worker thread and reply later
+            jreq.defer = [&]() -> RPCReplyFunction {
+                deferred = true;
+                std::shared_ptr<HTTPRequest> detached{req->Detach()};
+                return [detached, id = jreq.id](std::function<UniValue()> fn) {
+                    auto reply{[detached, id, fn = std::move(fn)] {
+                        try {
+                            const UniValue result{fn()};
+                            detached->WriteHeader("Content-Type", "application/json");
+                            detached->WriteReply(HTTP_OK, JSONRPCReply(result, NullUniValue, id));
+                        } catch (const UniValue& objError) {
+                            JSONErrorReply(detached.get(), objError, id);
+                        } catch (const std::exception& e) {
+                            JSONErrorReply(detached.get(), JSONRPCError(RPC_MISC_ERROR, e.what()), id);
+                        }
+                    }};
+                    // The caller may hold locks, so encode and send the reply
+                    // on a worker thread, unless the queue is full or the
+                    // server is shutting down.
+                    if (!EnqueueHTTPWork(reply)) reply();
+                };
+            };
             UniValue result = tableRPC.execute(jreq);
+            if (deferred) return true;
 
             // Send reply
             strReply = JSONRPCReply(result, NullUniValue, jreq.id);
@@ -230,9 +256,11 @@ static bool HTTPReq_JSONRPC(const std::any& context, HTTPRequest* req)
         req->WriteHeader("Content-Type", "application/json");
         req->WriteReply(HTTP_OK, strReply);
     } catch (const UniValue& objError) {
+        if (deferred) return false;
         JSONErrorReply(req, objError, jreq.id);
         return false;
     } catch (const std::exception& e) {
+        if (deferred) return false;
         JSONErrorReply(req, JSONRPCError(RPC_PARSE_ERROR, e.what()), jreq.id);
         return false;
     }
@@ -67,6 +67,22 @@ private:
     HTTPRequestHandler func;
 };
 
+/** Work item running a function, see EnqueueHTTPWork() */
+class HTTPFunctionWorkItem final : public HTTPClosure
+{
+public:
+    explicit HTTPFunctionWorkItem(std::function<void()> func) : m_func(std::move(func))
+    {
+    }
+    void operator()() override
+    {
+        m_func();
+    }
+
+private:
+    std::function<void()> m_func;
+};
+
 /** Simple work queue for distributing work over multiple threads.
  * Work items are simply callable objects.
  */
@@ -667,6 +683,15 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     req = nullptr; // transferred back to main thread
 }
 
+std::unique_ptr<HTTPRequest> HTTPRequest::Detach()
+{
+    assert(!replySent && req);
+    auto detached{std::make_unique<HTTPRequest>(req)};
+    replySent = true;
+    req = nullptr;
+    return detached;
+}
+
 CService HTTPRequest::GetPeer() const
 {
     evhttp_connection* con = evhttp_request_get_connection(req);
@@ -763,3 +788,12 @@ void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch)
         pathHandlers.erase(i);
     }
 }
+
+bool EnqueueHTTPWork(std::function<void()> fn)
+{
+    if (!g_work_queue) return false;
+    auto item{std::make_unique<HTTPFunctionWorkItem>(std::move(fn))};
+    if (!g_work_queue->Enqueue(item.get())) return false;
+    item.release(); // the queue took ownership
+    return true;
+}
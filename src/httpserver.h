@@ -6,6 +6,7 @@
 #define BITCOIN_HTTPSERVER_H
 
 #include <functional>
+#include <memory>
 #include <optional>
 #include <string>
 
@@ -44,6 +45,10 @@ typedef std::function<bool(HTTPRequest* req, const std::string &)> HTTPRequestHa
 void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler);
 /** Unregister handler for prefix */
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
+/** Run a function on an HTTP worker thread.
+ * Returns false if the work queue is full or the server was interrupted.
+ */
+bool EnqueueHTTPWork(std::function<void()> fn);
 
 /** Return evhttp event base. This can be used by submodules to
  * queue timers or custom events.
@@ -124,6 +129,14 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+
+    /**
+     * Take over the request, to reply to it after the handler returned.
+     *
+     * The returned request can be replied to from any thread. This one must
+     * not be used anymore.
+     */
+    std::unique_ptr<HTTPRequest> Detach();
 };
 
 /** Get the query parameter value from request uri for a specified key, or std::nullopt if the key
@@ -12,6 +12,9 @@
 
 class CChainParams;
 
+/** Default for -persistpowhashes, whether to store block PoW hashes in the block index database */
+static constexpr bool DEFAULT_PERSIST_POW_HASHES{false};
+
 namespace kernel {
 
 /**
@@ -22,6 +25,7 @@ struct BlockManagerOpts {
     const CChainParams& chainparams;
     uint64_t prune_target{0};
     bool fast_prune{false};
+    bool persist_pow_hashes{DEFAULT_PERSIST_POW_HASHES};
     const fs::path blocks_dir;
     Notifications& notifications;
 };
@@ -168,6 +168,12 @@ public:
             .nTxCount = 0,
             .dTxRate  = 0,
         };
+
+        // Generated by contrib/devtools/headerssync-params.py.
+        m_headers_sync_params = HeadersSyncParams{
+            .commitment_period = 354,
+            .redownload_buffer_size = 6341, // 6341/354 = ~17.9 commitments
+        };
     }
 };
 
@@ -271,6 +277,12 @@ public:
             .nTxCount = 0,
             .dTxRate  = 0,
         };
+
+        // Generated by contrib/devtools/headerssync-params.py.
+        m_headers_sync_params = HeadersSyncParams{
+            .commitment_period = 354,
+            .redownload_buffer_size = 6341, // 6341/354 = ~17.9 commitments
+        };
     }
 };
 
@@ -316,6 +328,12 @@ public:
             LogPrintf("Signet with challenge %s\n", HexStr(bin));
         }
 
+        // Generated by contrib/devtools/headerssync-params.py.
+        m_headers_sync_params = HeadersSyncParams{
+            .commitment_period = 354,
+            .redownload_buffer_size = 6341, // 6341/354 = ~17.9 commitments
+        };
+
         if (options.seeds) {
             vSeeds = *options.seeds;
         }
@@ -511,6 +529,12 @@ public:
             0
         };
 
+        // Generated by contrib/devtools/headerssync-params.py.
+        m_headers_sync_params = HeadersSyncParams{
+            .commitment_period = 354,
+            .redownload_buffer_size = 6341, // 6341/354 = ~17.9 commitments
+        };
+
         base58Prefixes[PUBKEY_ADDRESS] = std::vector<unsigned char>(1,111);
         base58Prefixes[SCRIPT_ADDRESS] = std::vector<unsigned char>(1,196);
         base58Prefixes[SECRET_KEY] =     std::vector<unsigned char>(1,239);
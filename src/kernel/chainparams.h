@@ -73,6 +73,20 @@ struct ChainTxData {
     double dTxRate;   //!< estimated number of transactions per second after that timestamp
 };
 
+/**
+ * Configuration for headers sync memory usage, derived per chain with the
+ * simulation script in contrib/devtools/headerssync-params.py.
+ *
+ * See also: CChainParams::HeadersSync, HeadersSyncState.
+ */
+struct HeadersSyncParams {
+    //! Distance in blocks between stored header commitments.
+    size_t commitment_period{0};
+    //! Minimum number of validated headers to accumulate in the redownload
+    //! buffer before feeding them into the permanent block index.
+    size_t redownload_buffer_size{0};
+};
+
 /**
  * CChainParams defines various tweakable parameters of a given instance of the
  * Bewcore system.
@@ -129,6 +143,7 @@ public:
     }
 
     const ChainTxData& TxData() const { return chainTxData; }
+    const HeadersSyncParams& HeadersSync() const { return m_headers_sync_params; }
 
     /**
      * SigNetOptions holds configurations for creating a signet CChainParams.
@@ -181,6 +196,7 @@ protected:
     CCheckpointData checkpointData;
     std::vector<AssumeutxoData> m_assumeutxo_data;
     ChainTxData chainTxData;
+    HeadersSyncParams m_headers_sync_params;
 };
 
 #endif // BITCOIN_KERNEL_CHAINPARAMS_H
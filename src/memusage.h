@@ -5,10 +5,12 @@
 #ifndef BITCOIN_MEMUSAGE_H
 #define BITCOIN_MEMUSAGE_H
 
+#include <flathashmap.h>
 #include <indirectmap.h>
 #include <prevector.h>
 #include <support/allocators/pool.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
 #include <list>
@@ -134,6 +136,21 @@ static inline size_t IncrementalDynamicUsage(const indirectmap<X, Y>& m)
     return MallocUsage(sizeof(stl_tree_node<std::pair<const X*, Y> >));
 }
 
+template<typename K, typename V, typename H, typename E>
+static inline size_t DynamicUsage(const FlatHashMap<K, V, H, E>& m)
+{
+    using Map = FlatHashMap<K, V, H, E>;
+    size_t usage{MallocUsage(sizeof(uint64_t) * m.SlotCount()) + MallocUsage(sizeof(void*) * m.ChunkPointerCapacity())};
+    const size_t chunks{m.ChunkCount()};
+    for (size_t chunk = 0; chunk < std::min(chunks, Map::GROWING_CHUNKS); ++chunk) {
+        usage += MallocUsage(sizeof(typename Map::value_type) * Map::ChunkEntries(chunk));
+    }
+    if (chunks > Map::GROWING_CHUNKS) {
+        usage += (chunks - Map::GROWING_CHUNKS) * MallocUsage(sizeof(typename Map::value_type) * Map::MAX_CHUNK_ENTRIES);
+    }
+    return usage;
+}
+
 template<typename X>
 static inline size_t DynamicUsage(const std::unique_ptr<X>& p)
 {
@@ -41,15 +41,19 @@
 #include <txrequest.h>
 #include <util/check.h> // For NDEBUG compile time check
 #include <util/strencodings.h>
+#include <util/thread.h>
 #include <util/trace.h>
 #include <validation.h>
 
 #include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <future>
 #include <memory>
 #include <optional>
+#include <thread>
 #include <typeinfo>
 
 /** Headers download timeout.
@@ -102,8 +106,11 @@ static constexpr auto OVERLOADED_PEER_TX_DELAY{2s};
 static constexpr auto GETDATA_TX_INTERVAL{60s};
 /** Limit to avoid sending big packets. Not used in processing incoming GETDATA for compatibility */
 static const unsigned int MAX_GETDATA_SZ = 1000;
-/** Number of blocks that can be requested at any given time from a single peer. */
-static const int MAX_BLOCKS_IN_TRANSIT_PER_PEER = 160;
+/** Number of blocks that can be requested at any given time from a single peer until its download
+ *  rate has been measured, and the lower bound of its adaptive limit (see UpdateBlockDownloadRate). */
+static const int MIN_BLOCKS_IN_TRANSIT_PER_PEER = 160;
+/** Upper bound of the number of blocks that can be requested at any given time from a single peer. */
+static const int MAX_BLOCKS_IN_TRANSIT_PER_PEER = 1024;
 /** Default time during which a peer must stall block download progress before being disconnected.
  * the actual timeout is increased temporarily if peers are disconnected for hitting the timeout */
 static constexpr auto BLOCK_STALLING_TIMEOUT_DEFAULT{2s};
@@ -117,11 +124,15 @@ static const unsigned int MAX_HEADERS_RESULTS = 2000;
 static const int MAX_CMPCTBLOCK_DEPTH = 5;
 /** Maximum depth of blocks we're willing to respond to GETBLOCKTXN requests for. */
 static const int MAX_BLOCKTXN_DEPTH = 10;
-/** Size of the "block download window": how far ahead of our current height do we fetch?
+/** Size of the "block download window" in bytes: how far ahead of our current height do we fetch?
  *  Larger windows tolerate larger download speed differences between peer, but increase the potential
- *  degree of disordering of blocks on disk (which make reindexing and pruning harder). We'll probably
- *  want to make this a per-peer adaptive value at some point. */
-static const unsigned int BLOCK_DOWNLOAD_WINDOW = 1024;
+ *  degree of disordering of blocks on disk (which make reindexing and pruning harder). It is converted
+ *  to a number of blocks using the average size of the blocks downloaded from each peer. */
+static constexpr uint64_t BLOCK_DOWNLOAD_WINDOW_BYTES{64 << 20};
+/** Lower bound of the block download window in blocks, used until a block has been downloaded from the peer. */
+static const int BLOCK_DOWNLOAD_WINDOW = 1024;
+/** Upper bound of the block download window in blocks, reached with blocks of 16 KiB on average. */
+static const int MAX_BLOCK_DOWNLOAD_WINDOW = 4096;
 /** Block download timeout base, expressed in multiples of the block interval (i.e. 10 min) */
 static constexpr double BLOCK_DOWNLOAD_TIMEOUT_BASE = 1;
 /** Additional block download timeout per parallel downloading peer (i.e. 5 min) */
@@ -184,6 +195,8 @@ struct QueuedBlock {
     const CBlockIndex* pindex;
     /** Optional, used for CMPCTBLOCK downloads */
     std::unique_ptr<PartiallyDownloadedBlock> partialBlock;
+    /** When the block was requested. */
+    std::chrono::microseconds m_time_requested;
 };
 
 /**
@@ -366,6 +379,11 @@ struct Peer {
     /** Work queue of items requested by this peer **/
     std::deque<CInv> m_getdata_requests GUARDED_BY(m_getdata_requests_mutex);
 
+    /** A BLOCK message from this peer queued on the BlockPrevalidator, and its size. No further
+     *  messages from this peer are processed until the block is, to keep them in order. */
+    std::future<std::shared_ptr<CBlock>> m_prevalidating_block GUARDED_BY(NetEventsInterface::g_msgproc_mutex);
+    size_t m_prevalidating_block_size GUARDED_BY(NetEventsInterface::g_msgproc_mutex){0};
+
     /** Time of the last getheaders message to this peer */
     NodeClock::time_point m_last_getheaders_timestamp GUARDED_BY(NetEventsInterface::g_msgproc_mutex){};
 
@@ -423,6 +441,16 @@ struct CNodeState {
     std::list<QueuedBlock> vBlocksInFlight;
     //! When the first entry in vBlocksInFlight started downloading. Don't care when vBlocksInFlight is empty.
     std::chrono::microseconds m_downloading_since{0us};
+    //! How many blocks may be in flight from this peer at once, see UpdateBlockDownloadRate.
+    int m_max_blocks_in_flight{MIN_BLOCKS_IN_TRANSIT_PER_PEER};
+    //! Moving average of the time this peer took to deliver each block we requested, or 0.
+    std::chrono::microseconds m_block_delivery_time{0us};
+    //! When we last received a block we requested from this peer.
+    std::chrono::microseconds m_last_block_received{0us};
+    //! Moving average of the size of the blocks we requested and received from this peer, or 0.
+    //! It is kept per peer, so a peer sending unusually small or large blocks only affects its own
+    //! block download window.
+    uint64_t m_avg_block_size{0};
     //! Whether we consider this a preferred download peer.
     bool fPreferredDownload{false};
     /** Whether this peer wants invs or cmpctblocks (when possible) for block announcements. */
@@ -476,6 +504,90 @@ struct CNodeState {
     CNodeState(bool is_inbound) : m_is_inbound(is_inbound) {}
 };
 
+/**
+ * Pool of threads that deserialize received BLOCK messages and run the context-free checks on
+ * the blocks: proof of work (memoizing the hash), merkle root and witness commitment. The blocks
+ * remember which checks passed, so ProcessNewBlock does not repeat them, and the message handler
+ * thread serves other peers in the meantime.
+ */
+class BlockPrevalidator
+{
+public:
+    BlockPrevalidator(int num_threads, ChainstateManager& chainman, CConnman& connman)
+        : m_chainman{chainman}, m_consensus_params{chainman.GetConsensus()}, m_connman{connman}
+    {
+        for (int n = 0; n < num_threads; ++n) {
+            m_threads.emplace_back(&util::TraceThread, strprintf("blkcheck.%i", n), [this] { ThreadPrevalidate(); });
+        }
+    }
+
+    ~BlockPrevalidator()
+    {
+        WITH_LOCK(m_mutex, m_stop = true);
+        m_cond.notify_all();
+        for (std::thread& thread : m_threads) thread.join();
+    }
+
+    /** Queue a BLOCK message. The result is nullptr if it does not deserialize. The message
+     *  handler is woken up when it is ready. */
+    std::future<std::shared_ptr<CBlock>> Submit(NodeId peer_id, CDataStream&& recv) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        std::packaged_task<std::shared_ptr<CBlock>()> task{[this, peer_id, recv = std::move(recv)]() mutable {
+            return Prevalidate(peer_id, recv);
+        }};
+        auto result{task.get_future()};
+        WITH_LOCK(m_mutex, m_queue.push_back(std::move(task)));
+        m_cond.notify_one();
+        return result;
+    }
+
+private:
+    std::shared_ptr<CBlock> Prevalidate(NodeId peer_id, CDataStream& recv) const
+    {
+        auto block{std::make_shared<CBlock>()};
+        try {
+            recv >> *block;
+        } catch (const std::exception& e) {
+            LogPrint(BCLog::NET, "Exception '%s' (%s) caught deserializing block from peer=%d\n", e.what(), typeid(e).name(), peer_id);
+            return nullptr;
+        }
+        // Failures are left to ProcessNewBlock, which runs into them again and
+        // handles them like for any other block.
+        BlockValidationState state;
+        if (CheckBlock(*block, state, m_consensus_params)) {
+            // Start reading the coins the block spends while it waits for
+            // the message handler.
+            if (CheckWitnessCommitment(*block, state)) m_chainman.PrefetchCoins(*block);
+        }
+        return block;
+    }
+
+    void ThreadPrevalidate() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        while (true) {
+            std::packaged_task<std::shared_ptr<CBlock>()> task;
+            {
+                WAIT_LOCK(m_mutex, lock);
+                m_cond.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_stop || !m_queue.empty(); });
+                if (m_stop) return;
+                task = std::move(m_queue.front());
+                m_queue.pop_front();
+            }
+            task();
+            m_connman.WakeMessageHandler();
+        }
+    }
+
+    ChainstateManager& m_chainman;
+    const Consensus::Params& m_consensus_params;
+    CConnman& m_connman;
+    Mutex m_mutex;
+    std::condition_variable m_cond;
+    std::deque<std::packaged_task<std::shared_ptr<CBlock>()>> m_queue GUARDED_BY(m_mutex);
+    bool m_stop GUARDED_BY(m_mutex){false};
+    std::vector<std::thread> m_threads;
+};
+
 class PeerManagerImpl final : public PeerManager
 {
 public:
@@ -599,8 +711,11 @@ private:
                                bool via_compact_block)
         EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, !m_headers_presync_mutex, g_msgproc_mutex);
     /** Various helpers for headers processing, invoked by ProcessHeadersMessage() */
-    /** Return true if headers are continuous and have valid proof-of-work (DoS points assigned on failure) */
-    bool CheckHeadersPoW(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams, Peer& peer);
+    /** Return true if headers are continuous and have valid proof-of-work (DoS points assigned on failure).
+     *  Headers that the peer's low-work headers sync already checked during
+     *  PRESYNC are not checked again. */
+    bool CheckHeadersPoW(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams, Peer& peer)
+        EXCLUSIVE_LOCKS_REQUIRED(!peer.m_headers_sync_mutex);
     /** Calculate an anti-DoS work threshold for headers chains */
     arith_uint256 GetAntiDoSWorkThreshold();
     /** Deal with state tracking and headers sync for peers that send the
@@ -616,6 +731,8 @@ private:
      *  @param[in]  peer                            The peer we're syncing with.
      *  @param[in]  pfrom                           CNode of the peer
      *  @param[in,out] headers                      The headers to be processed.
+     *  @param[out] presync_pow_checked             How many of the returned headers, from the front,
+     *                                              had their proof of work checked during PRESYNC.
      *  @return     True if the passed in headers were successfully processed
      *              as the continuation of a low-work headers sync in progress;
      *              false otherwise.
@@ -628,7 +745,7 @@ private:
      *              acceptance by the caller).
      */
     bool IsContinuationOfLowWorkHeadersSync(Peer& peer, CNode& pfrom,
-            std::vector<CBlockHeader>& headers)
+            std::vector<CBlockHeader>& headers, size_t& presync_pow_checked)
         EXCLUSIVE_LOCKS_REQUIRED(peer.m_headers_sync_mutex, !m_headers_presync_mutex, g_msgproc_mutex);
     /** Check work on a headers chain to be processed, and if insufficient,
      * initiate our anti-DoS headers sync mechanism.
@@ -709,6 +826,8 @@ private:
     CTxMemPool& m_mempool;
     TxRequestTracker m_txrequest GUARDED_BY(::cs_main);
     std::unique_ptr<TxReconciliationTracker> m_txreconciliation;
+    /** Deserializes and checks received blocks, unless block_prevalidation_threads is 0. */
+    std::unique_ptr<BlockPrevalidator> m_block_prevalidator;
 
     /** The height of the best chain */
     std::atomic<int> m_best_height{-1};
@@ -890,6 +1009,16 @@ private:
      */
     bool BlockRequested(NodeId nodeid, const CBlockIndex& block, std::list<QueuedBlock>::iterator** pit = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+    /** Measure how fast a peer delivered a block we requested from it, and adapt the number of blocks
+     *  we keep in flight from it to twice its bandwidth-delay product (its round-trip time over the
+     *  time it takes to deliver one block), so it never idles waiting for our next getdata. Must be
+     *  called before the request is removed. */
+    void UpdateBlockDownloadRate(const CNode& node, const uint256& hash, size_t block_size) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    /** Number of blocks past the last block we have in common with a peer that we are willing to
+     *  fetch: BLOCK_DOWNLOAD_WINDOW_BYTES worth of blocks of the average size downloaded from it. */
+    static int GetBlockDownloadWindow(const CNodeState& state);
+
     bool TipMayBeStale() EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     /** Update pindexLastCommonBlock and add not-in-flight missing successors to vBlocks, until it has
@@ -947,6 +1076,9 @@ private:
     /** Process a new block. Perform any post-processing housekeeping */
     void ProcessBlock(CNode& node, const std::shared_ptr<const CBlock>& block, bool force_processing, bool min_pow_checked);
 
+    /** Process a block received in a BLOCK message of block_size bytes */
+    void ProcessBlockMessage(CNode& pfrom, const std::shared_ptr<CBlock>& pblock, size_t block_size);
+
     /** Process compact block txns  */
     void ProcessCompactBlockTxns(CNode& pfrom, Peer& peer, const BlockTransactions& block_transactions)
         EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex, !m_most_recent_block_mutex);
@@ -1221,7 +1353,7 @@ bool PeerManagerImpl::BlockRequested(NodeId nodeid, const CBlockIndex& block, st
     RemoveBlockRequest(hash, nodeid);
 
     std::list<QueuedBlock>::iterator it = state->vBlocksInFlight.insert(state->vBlocksInFlight.end(),
-            {&block, std::unique_ptr<PartiallyDownloadedBlock>(pit ? new PartiallyDownloadedBlock(&m_mempool) : nullptr)});
+            {&block, std::unique_ptr<PartiallyDownloadedBlock>(pit ? new PartiallyDownloadedBlock(&m_mempool) : nullptr), GetTime<std::chrono::microseconds>()});
     if (state->vBlocksInFlight.size() == 1) {
         // We're starting a block download (batch) from this peer.
         state->m_downloading_since = GetTime<std::chrono::microseconds>();
@@ -1234,6 +1366,36 @@ bool PeerManagerImpl::BlockRequested(NodeId nodeid, const CBlockIndex& block, st
     return true;
 }
 
+void PeerManagerImpl::UpdateBlockDownloadRate(const CNode& node, const uint256& hash, size_t block_size)
+{
+    for (auto range = mapBlocksInFlight.equal_range(hash); range.first != range.second; range.first++) {
+        auto [node_id, list_it] = range.first->second;
+        if (node_id != node.GetId()) continue;
+
+        CNodeState& state = *Assert(State(node_id));
+        const auto now{GetTime<std::chrono::microseconds>()};
+        // The peer has been busy with this block since we requested it, or
+        // since it delivered the previous one if that was later.
+        const auto delivery_time{std::max(now - std::max(list_it->m_time_requested, state.m_last_block_received), 1us)};
+        state.m_last_block_received = now;
+        state.m_block_delivery_time = state.m_block_delivery_time == 0us ? delivery_time : (state.m_block_delivery_time * 7 + delivery_time) / 8;
+        state.m_avg_block_size = state.m_avg_block_size == 0 ? block_size : (state.m_avg_block_size * 31 + block_size) / 32;
+
+        // Without a ping we don't know the round-trip time; stay at the current limit.
+        const auto rtt{node.m_min_ping_time.load()};
+        if (rtt == std::chrono::microseconds::max()) return;
+        const int64_t bdp_blocks{rtt / std::max(state.m_block_delivery_time, 1us)};
+        state.m_max_blocks_in_flight = std::clamp<int64_t>(2 * bdp_blocks, MIN_BLOCKS_IN_TRANSIT_PER_PEER, MAX_BLOCKS_IN_TRANSIT_PER_PEER);
+        return;
+    }
+}
+
+int PeerManagerImpl::GetBlockDownloadWindow(const CNodeState& state)
+{
+    if (state.m_avg_block_size == 0) return BLOCK_DOWNLOAD_WINDOW;
+    return std::clamp<uint64_t>(BLOCK_DOWNLOAD_WINDOW_BYTES / state.m_avg_block_size, BLOCK_DOWNLOAD_WINDOW, MAX_BLOCK_DOWNLOAD_WINDOW);
+}
+
 void PeerManagerImpl::MaybeSetPeerAsAnnouncingHeaderAndIDs(NodeId nodeid)
 {
     AssertLockHeld(cs_main);
@@ -1380,10 +1542,10 @@ void PeerManagerImpl::FindNextBlocksToDownload(const Peer& peer, unsigned int co
         return;
 
     const CBlockIndex *pindexWalk = state->pindexLastCommonBlock;
-    // Never fetch further than the best block we know the peer has, or more than BLOCK_DOWNLOAD_WINDOW + 1 beyond the last
+    // Never fetch further than the best block we know the peer has, or more than the block download window + 1 beyond the last
     // linked block we have in common with this peer. The +1 is so we can detect stalling, namely if we would be able to
     // download that next block if the window were 1 larger.
-    int nWindowEnd = state->pindexLastCommonBlock->nHeight + BLOCK_DOWNLOAD_WINDOW;
+    int nWindowEnd = state->pindexLastCommonBlock->nHeight + GetBlockDownloadWindow(*state);
 
     FindNextBlocks(vBlocks, peer, state, pindexWalk, count, nWindowEnd, &m_chainman.ActiveChain(), &nodeStaller);
 }
@@ -1414,7 +1576,7 @@ void PeerManagerImpl::TryDownloadingHistoricalBlocks(const Peer& peer, unsigned
         return;
     }
 
-    FindNextBlocks(vBlocks, peer, state, from_tip, count, std::min<int>(from_tip->nHeight + BLOCK_DOWNLOAD_WINDOW, target_block->nHeight));
+    FindNextBlocks(vBlocks, peer, state, from_tip, count, std::min<int>(from_tip->nHeight + GetBlockDownloadWindow(*state), target_block->nHeight));
 }
 
 void PeerManagerImpl::FindNextBlocks(std::vector<const CBlockIndex*>& vBlocks, const Peer& peer, CNodeState *state, const CBlockIndex *pindexWalk, unsigned int count, int nWindowEnd, const CChain* activeChain, NodeId* nodeStaller)
@@ -1674,6 +1836,7 @@ bool PeerManagerImpl::GetNodeStateStats(NodeId nodeid, CNodeStateStats& stats) c
             if (queue.pindex)
                 stats.vHeightInFlight.push_back(queue.pindex->nHeight);
         }
+        stats.m_max_blocks_in_flight = state->m_max_blocks_in_flight;
     }
 
     PeerRef peer = GetPeerRef(nodeid);
@@ -1896,6 +2059,9 @@ PeerManagerImpl::PeerManagerImpl(CConnman& connman, AddrMan& addrman,
     if (opts.reconcile_txs) {
         m_txreconciliation = std::make_unique<TxReconciliationTracker>(TXRECONCILIATION_VERSION);
     }
+    if (opts.block_prevalidation_threads > 0) {
+        m_block_prevalidator = std::make_unique<BlockPrevalidator>(opts.block_prevalidation_threads, m_chainman, m_connman);
+    }
 }
 
 void PeerManagerImpl::StartScheduledTasks(CScheduler& scheduler)
@@ -2482,8 +2648,13 @@ void PeerManagerImpl::SendBlockTransactions(CNode& pfrom, Peer& peer, const CBlo
 
 bool PeerManagerImpl::CheckHeadersPoW(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams, Peer& peer)
 {
+    // Headers being redownloaded had their proof-of-work checked when they
+    // were first received during PRESYNC.
+    const size_t presync_checked{WITH_LOCK(peer.m_headers_sync_mutex,
+        return peer.m_headers_sync ? peer.m_headers_sync->CountPresyncCheckedHeaders(headers) : 0)};
+
     // Do these headers have proof-of-work matching what's claimed?
-    if (!HasValidProofOfWork(headers, consensusParams)) {
+    if (!HasValidProofOfWork(Span{headers}.subspan(presync_checked), consensusParams)) {
         Misbehaving(peer, 100, "header with invalid proof of work");
         return false;
     }
@@ -2559,7 +2730,7 @@ bool PeerManagerImpl::CheckHeadersAreContinuous(const std::vector<CBlockHeader>&
     return true;
 }
 
-bool PeerManagerImpl::IsContinuationOfLowWorkHeadersSync(Peer& peer, CNode& pfrom, std::vector<CBlockHeader>& headers)
+bool PeerManagerImpl::IsContinuationOfLowWorkHeadersSync(Peer& peer, CNode& pfrom, std::vector<CBlockHeader>& headers, size_t& presync_pow_checked)
 {
     if (peer.m_headers_sync) {
         auto result = peer.m_headers_sync->ProcessNextHeaders(headers, headers.size() == MAX_HEADERS_RESULTS);
@@ -2635,6 +2806,7 @@ bool PeerManagerImpl::IsContinuationOfLowWorkHeadersSync(Peer& peer, CNode& pfro
             // We only overwrite the headers passed in if processing was
             // successful.
             headers.swap(result.pow_validated_headers);
+            presync_pow_checked = result.presync_pow_checked;
         }
 
         return result.success;
@@ -2672,12 +2844,13 @@ bool PeerManagerImpl::TryLowWorkHeadersSync(Peer& peer, CNode& pfrom, const CBlo
             // advancing to the first unknown header would be a small effect.
             LOCK(peer.m_headers_sync_mutex);
             peer.m_headers_sync.reset(new HeadersSyncState(peer.m_id, m_chainparams.GetConsensus(),
-                chain_start_header, minimum_chain_work));
+                m_chainparams.HeadersSync(), chain_start_header, minimum_chain_work));
 
             // Now a HeadersSyncState object for tracking this synchronization
             // is created, process the headers using it as normal. Failures are
             // handled inside of IsContinuationOfLowWorkHeadersSync.
-            (void)IsContinuationOfLowWorkHeadersSync(peer, pfrom, headers);
+            size_t presync_pow_checked;
+            (void)IsContinuationOfLowWorkHeadersSync(peer, pfrom, headers, presync_pow_checked);
         } else {
             LogPrint(BCLog::NET, "Ignoring low-work chain (height=%u) from peer=%d\n", chain_start_header->nHeight + headers.size(), pfrom.GetId());
         }
@@ -2735,7 +2908,7 @@ void PeerManagerImpl::HeadersDirectFetchBlocks(CNode& pfrom, const Peer& peer, c
         std::vector<const CBlockIndex*> vToFetch;
         const CBlockIndex* pindexWalk{&last_header};
         // Calculate all the blocks we'd need to switch to last_header, up to a limit.
-        while (pindexWalk && !m_chainman.ActiveChain().Contains(pindexWalk) && vToFetch.size() <= MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
+        while (pindexWalk && !m_chainman.ActiveChain().Contains(pindexWalk) && vToFetch.size() <= static_cast<size_t>(nodestate->m_max_blocks_in_flight)) {
             if (!(pindexWalk->nStatus & BLOCK_HAVE_DATA) &&
                     !IsBlockRequested(pindexWalk->GetBlockHash()) &&
                     (!DeploymentActiveAt(*pindexWalk, m_chainman, Consensus::DEPLOYMENT_SEGWIT) || CanServeWitnesses(peer))) {
@@ -2756,7 +2929,7 @@ void PeerManagerImpl::HeadersDirectFetchBlocks(CNode& pfrom, const Peer& peer, c
             std::vector<CInv> vGetData;
             // Download as much as possible, from earliest to latest.
             for (const CBlockIndex *pindex : reverse_iterate(vToFetch)) {
-                if (nodestate->vBlocksInFlight.size() >= MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
+                if (nodestate->vBlocksInFlight.size() >= static_cast<size_t>(nodestate->m_max_blocks_in_flight)) {
                     // Can't download any more from this peer
                     break;
                 }
@@ -2888,12 +3061,17 @@ void PeerManagerImpl::ProcessHeadersMessage(CNode& pfrom, Peer& peer,
     // REDOWNLOAD) can be validated without further anti-DoS checks.
     bool already_validated_work = false;
 
+    // How many of the headers to process, from the front, are ones
+    // redownloaded during a low-work headers sync whose proof of work was
+    // checked during PRESYNC.
+    size_t presync_pow_checked{0};
+
     // If we're in the middle of headers sync, let it do its magic.
     bool have_headers_sync = false;
     {
         LOCK(peer.m_headers_sync_mutex);
 
-        already_validated_work = IsContinuationOfLowWorkHeadersSync(peer, pfrom, headers);
+        already_validated_work = IsContinuationOfLowWorkHeadersSync(peer, pfrom, headers, presync_pow_checked);
 
         // The headers we passed in may have been:
         // - untouched, perhaps if no headers-sync was in progress, or some
@@ -2966,9 +3144,10 @@ void PeerManagerImpl::ProcessHeadersMessage(CNode& pfrom, Peer& peer,
     // something new (if these headers are valid).
     bool received_new_header{last_received_header == nullptr};
 
-    // Now process all the headers.
+    // Now process all the headers. Validation need not check the proof of
+    // work of the ones checked during PRESYNC again.
     BlockValidationState state;
-    if (!m_chainman.ProcessNewBlockHeaders(headers, /*min_pow_checked=*/true, state, &pindexLast)) {
+    if (!m_chainman.ProcessNewBlockHeaders(headers, /*min_pow_checked=*/true, state, &pindexLast, /*pow_checked=*/presync_pow_checked)) {
         if (state.IsInvalid()) {
             MaybePunishNodeForBlock(pfrom.GetId(), state, via_compact_block, "invalid header received");
             return;
@@ -3260,6 +3439,34 @@ void PeerManagerImpl::ProcessBlock(CNode& node, const std::shared_ptr<const CBlo
     }
 }
 
+void PeerManagerImpl::ProcessBlockMessage(CNode& pfrom, const std::shared_ptr<CBlock>& pblock, size_t block_size)
+{
+    LogPrint(BCLog::NET, "received block %s peer=%d\n", pblock->GetHash().ToString(), pfrom.GetId());
+
+    bool forceProcessing = false;
+    const uint256 hash(pblock->GetHash());
+    bool min_pow_checked = false;
+    {
+        LOCK(cs_main);
+        // Always process the block if we requested it, since we may
+        // need it even when it's not a candidate for a new best tip.
+        forceProcessing = IsBlockRequested(hash);
+        UpdateBlockDownloadRate(pfrom, hash, block_size);
+        RemoveBlockRequest(hash, pfrom.GetId());
+        // mapBlockSource is only used for punishing peers and setting
+        // which peers send us compact blocks, so the race between here and
+        // cs_main in ProcessNewBlock is fine.
+        mapBlockSource.emplace(hash, std::make_pair(pfrom.GetId(), true));
+
+        // Check work on this block against our anti-dos thresholds.
+        const CBlockIndex* prev_block = m_chainman.m_blockman.LookupBlockIndex(pblock->hashPrevBlock);
+        if (prev_block && prev_block->nChainWork + CalculateHeadersWork({pblock->GetBlockHeader()}) >= GetAntiDoSWorkThreshold()) {
+            min_pow_checked = true;
+        }
+    }
+    ProcessBlock(pfrom, pblock, forceProcessing, min_pow_checked);
+}
+
 void PeerManagerImpl::ProcessCompactBlockTxns(CNode& pfrom, Peer& peer, const BlockTransactions& block_transactions)
 {
     std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
@@ -4482,7 +4689,7 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
         // We want to be a bit conservative just to be extra careful about DoS
         // possibilities in compact block processing...
         if (pindex->nHeight <= m_chainman.ActiveChain().Height() + 2) {
-            if ((already_in_flight < MAX_CMPCTBLOCKS_INFLIGHT_PER_BLOCK && nodestate->vBlocksInFlight.size() < MAX_BLOCKS_IN_TRANSIT_PER_PEER) ||
+            if ((already_in_flight < MAX_CMPCTBLOCKS_INFLIGHT_PER_BLOCK && nodestate->vBlocksInFlight.size() < static_cast<size_t>(nodestate->m_max_blocks_in_flight)) ||
                  requested_block_from_this_peer) {
                 std::list<QueuedBlock>::iterator* queuedBlockIt = nullptr;
                 if (!BlockRequested(pfrom.GetId(), *pindex, &queuedBlockIt)) {
@@ -4684,32 +4891,17 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
             return;
         }
 
+        const size_t block_size{vRecv.size()};
+        if (m_block_prevalidator) {
+            // Picked up again in ProcessMessages once it is done.
+            peer->m_prevalidating_block = m_block_prevalidator->Submit(pfrom.GetId(), std::move(vRecv));
+            peer->m_prevalidating_block_size = block_size;
+            return;
+        }
+
         std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
         vRecv >> *pblock;
-
-        LogPrint(BCLog::NET, "received block %s peer=%d\n", pblock->GetHash().ToString(), pfrom.GetId());
-
-        bool forceProcessing = false;
-        const uint256 hash(pblock->GetHash());
-        bool min_pow_checked = false;
-        {
-            LOCK(cs_main);
-            // Always process the block if we requested it, since we may
-            // need it even when it's not a candidate for a new best tip.
-            forceProcessing = IsBlockRequested(hash);
-            RemoveBlockRequest(hash, pfrom.GetId());
-            // mapBlockSource is only used for punishing peers and setting
-            // which peers send us compact blocks, so the race between here and
-            // cs_main in ProcessNewBlock is fine.
-            mapBlockSource.emplace(hash, std::make_pair(pfrom.GetId(), true));
-
-            // Check work on this block against our anti-dos thresholds.
-            const CBlockIndex* prev_block = m_chainman.m_blockman.LookupBlockIndex(pblock->hashPrevBlock);
-            if (prev_block && prev_block->nChainWork + CalculateHeadersWork({pblock->GetBlockHeader()}) >= GetAntiDoSWorkThreshold()) {
-                min_pow_checked = true;
-            }
-        }
-        ProcessBlock(pfrom, pblock, forceProcessing, min_pow_checked);
+        ProcessBlockMessage(pfrom, pblock, block_size);
         return;
     }
 
@@ -5041,6 +5233,16 @@ bool PeerManagerImpl::ProcessMessages(CNode* pfrom, std::atomic<bool>& interrupt
         if (!peer->m_getdata_requests.empty()) return true;
     }
 
+    // Process the peer's messages in order: wait for the block it sent last
+    // to be prevalidated. The BlockPrevalidator wakes us up when it is.
+    if (peer->m_prevalidating_block.valid()) {
+        if (peer->m_prevalidating_block.wait_for(0s) != std::future_status::ready) return false;
+        if (const auto block{peer->m_prevalidating_block.get()}) {
+            ProcessBlockMessage(*pfrom, block, peer->m_prevalidating_block_size);
+            if (pfrom->fDisconnect) return false;
+        }
+    }
+
     // Don't bother if send buffer is too full to respond anyway
     if (pfrom->fPauseSend) return false;
 
@@ -5932,11 +6134,11 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
         // Message: getdata (blocks)
         //
         std::vector<CInv> vGetData;
-        if (CanServeBlocks(*peer) && ((sync_blocks_and_headers_from_peer && !IsLimitedPeer(*peer)) || !m_chainman.IsInitialBlockDownload()) && state.vBlocksInFlight.size() < MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
+        if (CanServeBlocks(*peer) && ((sync_blocks_and_headers_from_peer && !IsLimitedPeer(*peer)) || !m_chainman.IsInitialBlockDownload()) && state.vBlocksInFlight.size() < static_cast<size_t>(state.m_max_blocks_in_flight)) {
             std::vector<const CBlockIndex*> vToDownload;
             NodeId staller = -1;
             auto get_inflight_budget = [&state]() {
-                return std::max(0, MAX_BLOCKS_IN_TRANSIT_PER_PEER - static_cast<int>(state.vBlocksInFlight.size()));
+                return std::max(0, state.m_max_blocks_in_flight - static_cast<int>(state.vBlocksInFlight.size()));
             };
 
             // If a snapshot chainstate is in use, we want to find its next blocks
@@ -21,6 +21,10 @@ static const uint32_t DEFAULT_MAX_ORPHAN_TRANSACTIONS{100};
 /** Default number of non-mempool transactions to keep around for block reconstruction. Includes
     orphan, replaced, and rejected transactions. */
 static const uint32_t DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN{100};
+/** Default number of threads that deserialize and check received blocks off the message handler thread. */
+static const int DEFAULT_BLOCK_PREVALIDATION_THREADS{2};
+/** Maximum number of block prevalidation threads. */
+static const int MAX_BLOCK_PREVALIDATION_THREADS{16};
 static const bool DEFAULT_PEERBLOOMFILTERS = false;
 static const bool DEFAULT_PEERBLOCKFILTERS = false;
 /** Threshold for marking a node to be discouraged, e.g. disconnected and added to the discouragement filter. */
@@ -34,6 +38,7 @@ struct CNodeStateStats {
     int m_starting_height = -1;
     std::chrono::microseconds m_ping_wait;
     std::vector<int> vHeightInFlight;
+    int m_max_blocks_in_flight{0};
     bool m_relay_txs;
     CAmount m_fee_filter_received;
     uint64_t m_addr_processed = 0;
@@ -56,6 +61,9 @@ public:
         //! Number of non-mempool transactions to keep around for block reconstruction. Includes
         //! orphan, replaced, and rejected transactions.
         uint32_t max_extra_txs{DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN};
+        //! Number of threads that deserialize and check received blocks before they are
+        //! processed. With 0, this happens on the message handler thread.
+        int block_prevalidation_threads{DEFAULT_BLOCK_PREVALIDATION_THREADS};
         //! Whether all P2P messages are captured to disk
         bool capture_messages{false};
         //! Whether or not the internal RNG behaves deterministically (this is
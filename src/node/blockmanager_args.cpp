@@ -33,6 +33,8 @@ util::Result<void> ApplyArgsManOptions(const ArgsManager& args, BlockManager::Op
 
     if (auto value{args.GetBoolArg("-fastprune")}) opts.fast_prune = *value;
 
+    if (auto value{args.GetBoolArg("-persistpowhashes")}) opts.persist_pow_hashes = *value;
+
     return {};
 }
 } // namespace node
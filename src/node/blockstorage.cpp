@@ -27,6 +27,7 @@
 #include <util/translation.h>
 #include <validation.h>
 
+#include <algorithm>
 #include <map>
 #include <unordered_map>
 
@@ -36,6 +37,7 @@ static constexpr uint8_t DB_BLOCK_INDEX{'b'};
 static constexpr uint8_t DB_FLAG{'F'};
 static constexpr uint8_t DB_REINDEX_FLAG{'R'};
 static constexpr uint8_t DB_LAST_BLOCK{'l'};
+static constexpr uint8_t DB_BLOCK_POW_HASH{'p'};
 // Keys used in previous version that might still be found in the DB:
 // BlockTreeDB::DB_TXINDEX_BLOCK{'T'};
 // BlockTreeDB::DB_TXINDEX{'t'}
@@ -65,7 +67,7 @@ bool BlockTreeDB::ReadLastBlockFile(int& nFile)
     return Read(DB_LAST_BLOCK, nFile);
 }
 
-bool BlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*>>& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo)
+bool BlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*>>& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo, const std::vector<std::pair<uint256, uint256>>& pow_hashes)
 {
     CDBBatch batch(*this);
     for (const auto& [file, info] : fileInfo) {
@@ -75,6 +77,9 @@ bool BlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockFi
     for (const CBlockIndex* bi : blockinfo) {
         batch.Write(std::make_pair(DB_BLOCK_INDEX, bi->GetBlockHash()), CDiskBlockIndex{bi});
     }
+    for (const auto& [block_hash, pow_hash] : pow_hashes) {
+        batch.Write(std::make_pair(DB_BLOCK_POW_HASH, block_hash), pow_hash);
+    }
     return WriteBatch(batch, true);
 }
 
@@ -129,11 +134,8 @@ bool BlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams, s
                 While it is technically feasible to verify the PoW, doing so takes several minutes as it
                 requires recomputing every PoW hash during every Litecoin startup.
                 We opt instead to simply trust the data that is on your local disk.
-                */
-				/*
-                if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits, consensusParams)) {
-                    return error("%s: CheckProofOfWork failed: %s", __func__, pindexNew->ToString());
-                }
+                With -persistpowhashes the yespower hashes are stored on disk and
+                checked cheaply by LoadBlockPoWHashes() instead.
                 */
 
                 pcursor->Next();
@@ -147,6 +149,40 @@ bool BlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams, s
 
     return true;
 }
+
+bool BlockTreeDB::ReadBlockPoWHash(const uint256& block_hash, uint256& pow_hash)
+{
+    return Read(std::make_pair(DB_BLOCK_POW_HASH, block_hash), pow_hash);
+}
+
+bool BlockTreeDB::LoadBlockPoWHashes(const Consensus::Params& consensusParams, std::function<const CBlockIndex*(const uint256&)> lookupBlockIndex, std::vector<const CBlockIndex*>& with_pow_hash, const util::SignalInterrupt& interrupt)
+{
+    AssertLockHeld(::cs_main);
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    pcursor->Seek(std::make_pair(DB_BLOCK_POW_HASH, uint256()));
+
+    while (pcursor->Valid()) {
+        if (interrupt) return false;
+        std::pair<uint8_t, uint256> key;
+        if (!pcursor->GetKey(key) || key.first != DB_BLOCK_POW_HASH) break;
+        uint256 pow_hash;
+        if (!pcursor->GetValue(pow_hash)) {
+            return error("%s: failed to read value", __func__);
+        }
+        // Entries for blocks no longer in the index are harmless, skip them.
+        const CBlockIndex* pindex{lookupBlockIndex(key.second)};
+        if (pindex) {
+            // The genesis block is never checked against its target.
+            if (pindex->pprev && !CheckProofOfWork(pow_hash, pindex->nBits, consensusParams)) {
+                return error("%s: CheckProofOfWork failed: %s", __func__, pindex->ToString());
+            }
+            with_pow_hash.push_back(pindex);
+        }
+        pcursor->Next();
+    }
+
+    return true;
+}
 } // namespace kernel
 
 namespace node {
@@ -223,6 +259,15 @@ CBlockIndex* BlockManager::AddToBlockIndex(const CBlockHeader& block, CBlockInde
         pindexNew->nHeight = pindexNew->pprev->nHeight + 1;
         pindexNew->BuildSkip();
     }
+    /* YespowerSugar */
+    // Store the PoW hash computed while checking the header, if still memoized.
+    if (m_opts.persist_pow_hashes && pindexNew->pprev) {
+        if (const auto pow_hash{GetMemoizedPoWHash(pindexNew->GetBlockHash())}) {
+            m_dirty_pow_hashes.emplace_back(pindexNew->GetBlockHash(), *pow_hash);
+        } else {
+            m_pow_hash_backfill.push_back(pindexNew);
+        }
+    }
     pindexNew->nTimeMax = (pindexNew->pprev ? std::max(pindexNew->pprev->nTimeMax, pindexNew->nTime) : pindexNew->nTime);
     pindexNew->nChainWork = (pindexNew->pprev ? pindexNew->pprev->nChainWork : 0) + GetBlockProof(*pindexNew);
     pindexNew->RaiseValidity(BLOCK_VALID_TREE);
@@ -397,6 +442,13 @@ bool BlockManager::LoadBlockIndex(const std::optional<uint256>& snapshot_blockha
         return false;
     }
 
+    std::vector<const CBlockIndex*> with_pow_hash;
+    if (m_opts.persist_pow_hashes && !m_block_tree_db->LoadBlockPoWHashes(
+            GetConsensus(), [this](const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main) { return this->LookupBlockIndex(hash); }, with_pow_hash, m_interrupt)) {
+        return false;
+    }
+    std::sort(with_pow_hash.begin(), with_pow_hash.end());
+
     if (snapshot_blockhash) {
         const std::optional<AssumeutxoData> maybe_au_data = GetParams().AssumeutxoForBlockhash(*snapshot_blockhash);
         if (!maybe_au_data) {
@@ -463,6 +515,9 @@ bool BlockManager::LoadBlockIndex(const std::optional<uint256>& snapshot_blockha
         if (pindex->pprev) {
             pindex->BuildSkip();
         }
+        if (m_opts.persist_pow_hashes && pindex->pprev && !std::binary_search(with_pow_hash.begin(), with_pow_hash.end(), pindex)) {
+            m_pow_hash_backfill.push_back(pindex);
+        }
     }
 
     return true;
@@ -484,12 +539,53 @@ bool BlockManager::WriteBlockIndexDB()
         m_dirty_blockindex.erase(it++);
     }
     int max_blockfile = WITH_LOCK(cs_LastBlockFile, return this->MaxBlockfileNum());
-    if (!m_block_tree_db->WriteBatchSync(vFiles, max_blockfile, vBlocks)) {
+    if (!m_block_tree_db->WriteBatchSync(vFiles, max_blockfile, vBlocks, m_dirty_pow_hashes)) {
         return false;
     }
+    m_dirty_pow_hashes.clear();
     return true;
 }
 
+size_t BlockManager::BackfillPoWHashes(size_t max_count, yespower_local_t* local)
+{
+    std::vector<std::pair<const CBlockIndex*, CBlockHeader>> todo;
+    {
+        LOCK(cs_main);
+        while (!m_pow_hash_backfill.empty() && todo.size() < max_count) {
+            const CBlockIndex* pindex{m_pow_hash_backfill.back()};
+            m_pow_hash_backfill.pop_back();
+            todo.emplace_back(pindex, pindex->GetBlockHeader());
+        }
+    }
+    if (todo.empty()) return 0;
+
+    // Compute the hashes without holding cs_main, unless validation has
+    // memoized them in the meantime.
+    std::vector<uint256> pow_hashes;
+    pow_hashes.reserve(todo.size());
+    for (const auto& [pindex, header] : todo) {
+        const uint256 block_hash{pindex->GetBlockHash()};
+        if (const auto pow_hash{GetMemoizedPoWHash(block_hash)}) {
+            pow_hashes.push_back(*pow_hash);
+            continue;
+        }
+        pow_hashes.push_back(GetSerializedHeaderPoWHash(header.SerializeToArray(), local));
+        MemoizePoWHash(block_hash, pow_hashes.back());
+    }
+
+    LOCK(cs_main);
+    for (size_t i = 0; i < todo.size(); ++i) {
+        const CBlockIndex* pindex{todo[i].first};
+        if (!CheckProofOfWork(pow_hashes[i], pindex->nBits, GetConsensus())) {
+            LogPrintf("ERROR: %s: CheckProofOfWork failed: %s\n", __func__, pindex->ToString());
+            m_opts.notifications.warning(strprintf(_("The block index entry for block %s does not meet its proof-of-work target. Your block database may be corrupted, consider running with -reindex."), pindex->GetBlockHash().ToString()));
+            continue;
+        }
+        m_dirty_pow_hashes.emplace_back(pindex->GetBlockHash(), pow_hashes[i]);
+    }
+    return todo.size();
+}
+
 bool BlockManager::LoadBlockIndexDB(const std::optional<uint256>& snapshot_blockhash)
 {
     if (!LoadBlockIndex(snapshot_blockhash)) {
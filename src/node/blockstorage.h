@@ -13,6 +13,7 @@
 #include <kernel/chainparams.h>
 #include <kernel/cs_main.h>
 #include <kernel/messagestartchars.h>
+#include <primitives/block.h>
 #include <sync.h>
 #include <util/fs.h>
 #include <util/hasher.h>
@@ -51,7 +52,7 @@ class BlockTreeDB : public CDBWrapper
 {
 public:
     using CDBWrapper::CDBWrapper;
-    bool WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*>>& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo);
+    bool WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*>>& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo, const std::vector<std::pair<uint256, uint256>>& pow_hashes = {});
     bool ReadBlockFileInfo(int nFile, CBlockFileInfo& info);
     bool ReadLastBlockFile(int& nFile);
     bool WriteReindexing(bool fReindexing);
@@ -60,6 +61,11 @@ public:
     bool ReadFlag(const std::string& name, bool& fValue);
     bool LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex, const util::SignalInterrupt& interrupt)
         EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+    /** Check each stored PoW hash against the target of its loaded block
+     *  index entry, and collect the entries that have one. */
+    bool LoadBlockPoWHashes(const Consensus::Params& consensusParams, std::function<const CBlockIndex*(const uint256&)> lookupBlockIndex, std::vector<const CBlockIndex*>& with_pow_hash, const util::SignalInterrupt& interrupt)
+        EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+    bool ReadBlockPoWHash(const uint256& block_hash, uint256& pow_hash);
 };
 } // namespace kernel
 
@@ -76,6 +82,9 @@ static const unsigned int MAX_BLOCKFILE_SIZE = 0x8000000; // 128 MiB
 /** Size of header written by WriteBlockToDisk before a serialized CBlock */
 static constexpr size_t BLOCK_SERIALIZATION_HEADER_SIZE = std::tuple_size_v<MessageStartChars> + sizeof(unsigned int);
 
+/** Number of missing PoW hashes computed per BackfillPoWHashes() run */
+static constexpr size_t POW_HASH_BACKFILL_BATCH{16};
+
 extern std::atomic_bool fReindex;
 
 // Because validation code takes pointers to the map's CBlockIndex objects, if
@@ -233,6 +242,12 @@ private:
     /** Dirty block index entries. */
     std::set<CBlockIndex*> m_dirty_blockindex;
 
+    /** Block index entries without a stored PoW hash (with -persistpowhashes). */
+    std::vector<const CBlockIndex*> m_pow_hash_backfill GUARDED_BY(::cs_main);
+
+    /** (block hash, PoW hash) pairs to store with the next flush (with -persistpowhashes). */
+    std::vector<std::pair<uint256, uint256>> m_dirty_pow_hashes GUARDED_BY(::cs_main);
+
     /** Dirty block file entries. */
     std::set<int> m_dirty_fileinfo;
 
@@ -286,6 +301,18 @@ public:
     std::unique_ptr<BlockTreeDB> m_block_tree_db GUARDED_BY(::cs_main);
 
     bool WriteBlockIndexDB() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+
+    /** Whether PoW hashes are stored in the block index database (-persistpowhashes). */
+    [[nodiscard]] bool PersistPoWHashes() const { return m_opts.persist_pow_hashes; }
+
+    /**
+     * Compute the PoW hash of up to max_count block index entries that have
+     * none stored, check it against the entry's target, and queue it to be
+     * written with the next flush. Hashes not memoized yet are computed in the
+     * given region, see GetSerializedHeaderPoWHash().
+     * Returns the number of entries processed.
+     */
+    size_t BackfillPoWHashes(size_t max_count, yespower_local_t* local = nullptr) EXCLUSIVE_LOCKS_REQUIRED(!::cs_main);
     bool LoadBlockIndexDB(const std::optional<uint256>& snapshot_blockhash)
         EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
@@ -0,0 +1,363 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/blocktemplatecache.h>
+
+#include <chain.h>
+#include <consensus/consensus.h>
+#include <consensus/merkle.h>
+#include <consensus/tx_verify.h>
+#include <consensus/validation.h>
+#include <kernel/mempool_removal_reason.h>
+#include <logging.h>
+#include <timedata.h>
+#include <script/script.h>
+#include <txmempool.h>
+#include <util/thread.h>
+#include <validation.h>
+
+#include <algorithm>
+#include <exception>
+#include <vector>
+
+namespace node {
+BlockTemplateCache::BlockTemplateCache(ChainstateManager& chainman, const CTxMemPool& mempool, const BlockAssembler::Options& options)
+    : m_chainman{chainman}, m_mempool{mempool}, m_options{options}
+{
+}
+
+BlockTemplateCache::~BlockTemplateCache()
+{
+    Stop();
+}
+
+void BlockTemplateCache::Start()
+{
+    assert(!m_thread.joinable());
+    m_thread = std::thread(&util::TraceThread, "blocktmpl", [this] { ThreadBuild(); });
+}
+
+void BlockTemplateCache::Stop()
+{
+    Interrupt();
+    WITH_LOCK(m_mutex, m_stop = true);
+    m_cv.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+std::shared_ptr<const BlockTemplateSnapshot> BlockTemplateCache::GetTemplate()
+{
+    AssertLockHeld(::cs_main);
+    m_active = true;
+    AppendPending();
+    {
+        LOCK(m_mutex);
+        if (m_template && !m_stale && m_template->prev == m_chainman.ActiveChain().Tip()) return m_template;
+    }
+    return Build();
+}
+
+void BlockTemplateCache::AddWaiter(const uint256& prev_hash, unsigned int transactions_updated,
+                                   std::chrono::steady_clock::time_point check_txs_time, WaiterFunction fn)
+{
+    AssertLockHeld(::cs_main);
+    m_active = true;
+    {
+        LOCK(m_mutex);
+        if (!m_interrupted) {
+            m_waiters.push_back({prev_hash, transactions_updated, check_txs_time, /*checked=*/false, std::move(fn)});
+            fn = nullptr;
+        }
+    }
+    if (fn) {
+        fn(nullptr);
+        return;
+    }
+    // Let the background thread pick up the deadline, and build the template
+    // if there is none.
+    m_cv.notify_all();
+    Notify();
+}
+
+void BlockTemplateCache::AddListener(ListenerFunction fn)
+{
+    WITH_LOCK(m_mutex, m_listeners.push_back(std::move(fn)));
+    m_active = true;
+    m_cv.notify_all();
+}
+
+void BlockTemplateCache::Interrupt()
+{
+    std::list<Waiter> waiters;
+    {
+        LOCK(m_mutex);
+        m_interrupted = true;
+        waiters.swap(m_waiters);
+    }
+    for (const Waiter& waiter : waiters) {
+        waiter.fn(nullptr);
+    }
+}
+
+void BlockTemplateCache::Notify()
+{
+    AssertLockHeld(::cs_main);
+    std::shared_ptr<const BlockTemplateSnapshot> snapshot;
+    std::vector<ListenerFunction> listeners;
+    std::vector<WaiterFunction> ready;
+    {
+        LOCK(m_mutex);
+        // The tip may have changed without UpdatedBlockTip having been
+        // called yet; waiters for it are called once it is built on.
+        if (m_stale || !m_template || m_template->prev != m_chainman.ActiveChain().Tip()) return;
+        snapshot = m_template;
+        if (snapshot->id != m_notified_id) {
+            m_notified_id = snapshot->id;
+            listeners = m_listeners;
+        }
+        const uint256 prev_hash{snapshot->prev->GetBlockHash()};
+        const auto now{SteadyClock::now()};
+        for (auto it{m_waiters.begin()}; it != m_waiters.end();) {
+            if (it->prev_hash != prev_hash || (now >= it->check_txs_time && it->transactions_updated != snapshot->transactions_updated)) {
+                ready.push_back(std::move(it->fn));
+                it = m_waiters.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (const ListenerFunction& fn : listeners) {
+        fn(snapshot);
+    }
+    // Every waiter gets the same template
+    for (const WaiterFunction& fn : ready) {
+        fn(snapshot);
+    }
+}
+
+std::shared_ptr<const BlockTemplateSnapshot> BlockTemplateCache::Build()
+{
+    AssertLockHeld(::cs_main);
+    const unsigned int transactions_updated{m_mempool.GetTransactionsUpdated()};
+    auto snapshot{std::make_shared<BlockTemplateSnapshot>()};
+    snapshot->tmpl = std::move(*BlockAssembler{m_chainman.ActiveChainstate(), &m_mempool, m_options}.CreateNewBlock(CScript() << OP_TRUE));
+    snapshot->prev = m_chainman.ActiveChain().Tip();
+    snapshot->transactions_updated = transactions_updated;
+
+    {
+        LOCK(m_mutex);
+        snapshot->id = m_next_id++;
+        m_txids.clear();
+        m_spent.clear();
+        // The transactions added to the mempool so far were selected from already.
+        m_pending.clear();
+        m_weight = 4000;
+        m_sigops_cost = 400;
+        const CBlock& block{snapshot->tmpl.block};
+        for (size_t i = 1; i < block.vtx.size(); ++i) {
+            m_txids.insert(block.vtx[i]->GetHash());
+            for (const CTxIn& txin : block.vtx[i]->vin) {
+                m_spent.insert(txin.prevout);
+            }
+            m_weight += GetTransactionWeight(*block.vtx[i]);
+            m_sigops_cost += snapshot->tmpl.vTxSigOpsCost[i];
+        }
+        m_template = snapshot;
+        m_stale = false;
+        m_outdated = false;
+        m_last_build = SteadyClock::now();
+    }
+    Notify();
+    return snapshot;
+}
+
+void BlockTemplateCache::AppendPending()
+{
+    AssertLockHeld(::cs_main);
+    {
+        LOCK2(m_mempool.cs, m_mutex);
+        if (m_pending.empty()) return;
+        std::vector<CTransactionRef> pending;
+        pending.swap(m_pending);
+        CBlockIndex* tip{m_chainman.ActiveChain().Tip()};
+        if (m_stale || !m_template || m_template->prev != tip) return;
+
+        std::shared_ptr<BlockTemplateSnapshot> snapshot;
+        CAmount fees{0};
+        for (const CTransactionRef& tx : pending) {
+            if (!Append(tx, snapshot, fees)) m_outdated = true;
+        }
+        if (!snapshot) return;
+
+        CBlockTemplate& tmpl{snapshot->tmpl};
+        CMutableTransaction coinbase{*tmpl.block.vtx[0]};
+        coinbase.vout[0].nValue += fees;
+        const int commitpos{GetWitnessCommitmentIndex(tmpl.block)};
+        if (commitpos != NO_WITNESS_COMMITMENT) coinbase.vout.erase(coinbase.vout.begin() + commitpos);
+        tmpl.block.vtx[0] = MakeTransactionRef(std::move(coinbase));
+        tmpl.vTxFees[0] -= fees;
+        tmpl.vchCoinbaseCommitment = m_chainman.GenerateCoinbaseCommitment(tmpl.block, tip);
+        tmpl.block.hashMerkleRoot = BlockMerkleRoot(tmpl.block);
+
+        BlockValidationState state;
+        if (!TestBlockValidity(state, m_chainman.GetParams(), m_chainman.ActiveChainstate(), tmpl.block, tip,
+                               GetAdjustedTime, /*fCheckPOW=*/false, /*fCheckMerkleRoot=*/false)) {
+            // m_txids and the counters include the transactions appended, so
+            // the template has to be rebuilt.
+            LogPrintf("Block template with appended transactions is invalid, rebuilding it: %s\n", state.ToString());
+            m_stale = true;
+            m_cv.notify_all();
+            return;
+        }
+        snapshot->transactions_updated = m_mempool.GetTransactionsUpdated();
+        snapshot->id = m_next_id++;
+        m_template = std::move(snapshot);
+    }
+    Notify();
+}
+
+bool BlockTemplateCache::Append(const CTransactionRef& tx, std::shared_ptr<BlockTemplateSnapshot>& snapshot, CAmount& fees)
+{
+    AssertLockHeld(::cs_main);
+    AssertLockHeld(m_mempool.cs);
+    AssertLockHeld(m_mutex);
+    const CBlockIndex* tip{m_chainman.ActiveChain().Tip()};
+    if (m_txids.count(tx->GetHash())) return true;
+
+    const auto entry{m_mempool.GetIter(tx->GetHash())};
+    if (!entry) return true;
+    // Like BlockAssembler, use the modified fee for selection and the
+    // actual fee for the template.
+    if ((*entry)->GetModifiedFee() < m_options.blockMinFeeRate.GetFee((*entry)->GetTxSize())) return true;
+    if (m_weight + (*entry)->GetTxWeight() >= m_options.nBlockMaxWeight) return false;
+    if (m_sigops_cost + (*entry)->GetSigOpCost() >= MAX_BLOCK_SIGOPS_COST) return false;
+    if (!IsFinalTx(*tx, tip->nHeight + 1, tip->GetMedianTimePast())) return false;
+    for (const CTxIn& txin : tx->vin) {
+        // A transaction conflicting with the template replaced one of its
+        // transactions, and the template has to be rebuilt anyway.
+        if (m_spent.count(txin.prevout)) return false;
+        if (m_mempool.GetIter(txin.prevout.hash) && !m_txids.count(txin.prevout.hash)) return false;
+    }
+
+    if (!snapshot) {
+        snapshot = std::make_shared<BlockTemplateSnapshot>();
+        snapshot->tmpl = m_template->tmpl;
+        snapshot->prev = m_template->prev;
+    }
+    CBlockTemplate& tmpl{snapshot->tmpl};
+    tmpl.block.vtx.push_back(tx);
+    tmpl.vTxFees.push_back((*entry)->GetFee());
+    tmpl.vTxSigOpsCost.push_back((*entry)->GetSigOpCost());
+    fees += (*entry)->GetFee();
+
+    m_txids.insert(tx->GetHash());
+    for (const CTxIn& txin : tx->vin) {
+        m_spent.insert(txin.prevout);
+    }
+    m_weight += (*entry)->GetTxWeight();
+    m_sigops_cost += (*entry)->GetSigOpCost();
+    return true;
+}
+
+void BlockTemplateCache::UpdatedBlockTip(const CBlockIndex* pindexNew, const CBlockIndex* pindexFork, bool fInitialDownload)
+{
+    if (!m_active) return;
+    {
+        LOCK(m_mutex);
+        m_stale = true;
+        m_initial_download = fInitialDownload;
+    }
+    m_cv.notify_all();
+}
+
+void BlockTemplateCache::TransactionAddedToMempool(const CTransactionRef& tx, uint64_t mempool_sequence)
+{
+    if (!m_active) return;
+    {
+        LOCK(m_mutex);
+        if (m_stale) return;
+        m_pending.push_back(tx);
+    }
+    m_cv.notify_all();
+}
+
+void BlockTemplateCache::TransactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRemovalReason reason, uint64_t mempool_sequence)
+{
+    // Mined transactions go with the tip.
+    if (reason == MemPoolRemovalReason::BLOCK || !m_active) return;
+    {
+        LOCK(m_mutex);
+        if (m_txids.count(tx->GetHash())) {
+            m_stale = true;
+        } else {
+            m_outdated = true;
+        }
+    }
+    m_cv.notify_all();
+}
+
+void BlockTemplateCache::ThreadBuild()
+{
+    while (true) {
+        bool build{false};
+        bool append{false};
+        {
+            WAIT_LOCK(m_mutex, lock);
+            while (true) {
+                if (m_stop) return;
+                const auto now{SteadyClock::now()};
+                const auto refresh_time{m_last_build + BLOCK_TEMPLATE_REFRESH_INTERVAL};
+                // Only build for every block during initial block download
+                // if someone is waiting for it.
+                const bool update{m_active && (!m_initial_download || !m_waiters.empty())};
+                if (update && (m_stale || (m_outdated && now >= refresh_time))) {
+                    build = true;
+                    break;
+                }
+                if (update && !m_pending.empty()) {
+                    append = true;
+                    break;
+                }
+                // Waiters whose deadline passed take the current template if
+                // the mempool changed since theirs.
+                auto wakeup{std::chrono::steady_clock::time_point::max()};
+                bool notify{false};
+                for (Waiter& waiter : m_waiters) {
+                    if (waiter.checked) continue;
+                    if (now >= waiter.check_txs_time) {
+                        waiter.checked = true;
+                        notify = true;
+                    } else {
+                        wakeup = std::min(wakeup, waiter.check_txs_time);
+                    }
+                }
+                if (notify) break;
+                if (update && m_outdated) wakeup = std::min(wakeup, refresh_time);
+                if (wakeup == std::chrono::steady_clock::time_point::max()) {
+                    m_cv.wait(lock);
+                } else {
+                    m_cv.wait_until(lock, wakeup);
+                }
+            }
+        }
+        try {
+            LOCK(::cs_main);
+            if (build) {
+                Build();
+            } else if (append) {
+                AppendPending();
+            } else {
+                Notify();
+            }
+        } catch (const std::exception& e) {
+            // Retry later, or when the template is requested.
+            LogPrintf("Failed to update the block template: %s\n", e.what());
+            LOCK(m_mutex);
+            m_last_build = SteadyClock::now();
+            m_stale = false;
+            m_outdated = true;
+        }
+    }
+}
+} // namespace node
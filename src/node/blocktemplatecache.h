@@ -0,0 +1,188 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_BLOCKTEMPLATECACHE_H
+#define BITCOIN_NODE_BLOCKTEMPLATECACHE_H
+
+#include <consensus/amount.h>
+#include <kernel/cs_main.h>
+#include <node/miner.h>
+#include <primitives/transaction.h>
+#include <sync.h>
+#include <uint256.h>
+#include <univalue.h>
+#include <util/hasher.h>
+#include <validationinterface.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+class CBlockIndex;
+class CTxMemPool;
+class ChainstateManager;
+
+namespace node {
+/** Interval after which a block template is rebuilt when the mempool changed in ways it could not follow */
+static constexpr std::chrono::seconds BLOCK_TEMPLATE_REFRESH_INTERVAL{5};
+
+/** A block template, as served to getblocktemplate. Never modified once published, other than caching its encoding. */
+struct BlockTemplateSnapshot {
+    CBlockTemplate tmpl;
+    //! The block the template builds on.
+    const CBlockIndex* prev;
+    //! CTxMemPool::GetTransactionsUpdated() when the template was last updated.
+    unsigned int transactions_updated;
+    //! Increases with every template published.
+    uint64_t id;
+    mutable Mutex json_mutex;
+    //! The transactions as encoded by getblocktemplate, shared by all calls served this template.
+    mutable std::optional<UniValue> transactions_json GUARDED_BY(json_mutex);
+};
+
+/**
+ * Keeps a block template for the current tip up to date as the mempool
+ * changes, so that getblocktemplate does not have to assemble a new block on
+ * every call.
+ *
+ * Transactions added to the mempool are appended to the template if their
+ * unconfirmed parents are in it already and they fit. This is done for all
+ * of those added meanwhile at once, on a background thread or when the
+ * template is requested, and the result is checked with TestBlockValidity
+ * before it is published. For transactions that cannot be appended, and for
+ * higher feerate ones that no longer fit, the template is rebuilt by
+ * BlockAssembler at most every BLOCK_TEMPLATE_REFRESH_INTERVAL, on the
+ * background thread. A new tip, removal of a template transaction for any
+ * reason other than being mined, or a failed check makes the template stale,
+ * and it is rebuilt right away.
+ *
+ * Longpolling callers register a waiter instead of blocking a thread each.
+ * Every template published is offered to all waiters, which are called back
+ * once it builds on another block than theirs, or once their deadline passed
+ * and the mempool changed.
+ *
+ * Listeners are called with every template published for the current tip.
+ *
+ * Nothing is done until the first template is requested or a listener is
+ * added, so nodes that do not mine do not pay for it.
+ */
+class BlockTemplateCache final : public CValidationInterface
+{
+public:
+    BlockTemplateCache(ChainstateManager& chainman, const CTxMemPool& mempool, const BlockAssembler::Options& options);
+    ~BlockTemplateCache();
+
+    /** Start the thread rebuilding the template in the background. */
+    void Start();
+    /** Stop the background thread. */
+    void Stop() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Return the template for the current tip, building it first if there
+     * is none. Throws like BlockAssembler::CreateNewBlock().
+     */
+    std::shared_ptr<const BlockTemplateSnapshot> GetTemplate() EXCLUSIVE_LOCKS_REQUIRED(::cs_main, !m_mutex);
+
+    /** Called with the template a longpoll waited for, or with nullptr on shutdown. Must not throw. */
+    using WaiterFunction = std::function<void(std::shared_ptr<const BlockTemplateSnapshot>)>;
+
+    /**
+     * Wait for a template building on another block than prev_hash, or, after
+     * check_txs_time, for one with other transactions than
+     * transactions_updated. The function may be called before this returns.
+     */
+    void AddWaiter(const uint256& prev_hash, unsigned int transactions_updated,
+                   std::chrono::steady_clock::time_point check_txs_time, WaiterFunction fn)
+        EXCLUSIVE_LOCKS_REQUIRED(::cs_main, !m_mutex);
+
+    /** Called with every template published for the current tip, holding cs_main. Must not throw. */
+    using ListenerFunction = std::function<void(const std::shared_ptr<const BlockTemplateSnapshot>&)>;
+
+    /** Keep the template up to date from now on, and call fn with every one published. */
+    void AddListener(ListenerFunction fn) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Call back all waiters with nullptr, and any added later right away. */
+    void Interrupt() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+protected:
+    // CValidationInterface
+    void UpdatedBlockTip(const CBlockIndex* pindexNew, const CBlockIndex* pindexFork, bool fInitialDownload) override
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void TransactionAddedToMempool(const CTransactionRef& tx, uint64_t mempool_sequence) override
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void TransactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRemovalReason reason, uint64_t mempool_sequence) override
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    /** Assemble a new template and publish it. */
+    std::shared_ptr<const BlockTemplateSnapshot> Build() EXCLUSIVE_LOCKS_REQUIRED(::cs_main, !m_mutex);
+    /**
+     * Append the transactions added to the mempool meanwhile to a copy of the
+     * current template, and publish it once it passed TestBlockValidity.
+     */
+    void AppendPending() EXCLUSIVE_LOCKS_REQUIRED(::cs_main, !m_mutex);
+    /**
+     * Add a mempool transaction to snapshot, a copy of the current template
+     * made if it is null, and its fee to fees. Returns false if the template
+     * has to be rebuilt to include it.
+     */
+    bool Append(const CTransactionRef& tx, std::shared_ptr<BlockTemplateSnapshot>& snapshot, CAmount& fees)
+        EXCLUSIVE_LOCKS_REQUIRED(::cs_main, m_mempool.cs, m_mutex);
+    /** Call the listeners if the current template is new, and the waiters it is for. */
+    void Notify() EXCLUSIVE_LOCKS_REQUIRED(::cs_main, !m_mutex);
+    void ThreadBuild() EXCLUSIVE_LOCKS_REQUIRED(!::cs_main, !m_mutex);
+
+    struct Waiter {
+        uint256 prev_hash;
+        unsigned int transactions_updated;
+        std::chrono::steady_clock::time_point check_txs_time;
+        //! Whether the background thread woke up for check_txs_time already.
+        bool checked;
+        WaiterFunction fn;
+    };
+
+    ChainstateManager& m_chainman;
+    const CTxMemPool& m_mempool;
+    const BlockAssembler::Options m_options;
+
+    Mutex m_mutex;
+    std::condition_variable m_cv;
+    std::shared_ptr<const BlockTemplateSnapshot> m_template GUARDED_BY(m_mutex);
+    //! Transactions of the current template and the outpoints they spend.
+    std::unordered_set<uint256, SaltedTxidHasher> m_txids GUARDED_BY(m_mutex);
+    std::unordered_set<COutPoint, SaltedOutpointHasher> m_spent GUARDED_BY(m_mutex);
+    //! Transactions added to the mempool since, to be appended to the template.
+    std::vector<CTransactionRef> m_pending GUARDED_BY(m_mutex);
+    //! Weight and sigop cost of the current template, with the same reserve for the coinbase as BlockAssembler.
+    uint64_t m_weight GUARDED_BY(m_mutex){0};
+    int64_t m_sigops_cost GUARDED_BY(m_mutex){0};
+    //! Whether a template was ever requested.
+    std::atomic<bool> m_active{false};
+    //! Whether the template may no longer be valid.
+    bool m_stale GUARDED_BY(m_mutex){true};
+    //! Whether the mempool changed in ways the template could not follow.
+    bool m_outdated GUARDED_BY(m_mutex){false};
+    //! Whether the tip was last updated during initial block download.
+    bool m_initial_download GUARDED_BY(m_mutex){false};
+    std::chrono::steady_clock::time_point m_last_build GUARDED_BY(m_mutex);
+    uint64_t m_next_id GUARDED_BY(m_mutex){1};
+    std::list<Waiter> m_waiters GUARDED_BY(m_mutex);
+    std::vector<ListenerFunction> m_listeners GUARDED_BY(m_mutex);
+    //! Id of the last template the listeners were called with.
+    uint64_t m_notified_id GUARDED_BY(m_mutex){0};
+    bool m_interrupted GUARDED_BY(m_mutex){false};
+    bool m_stop GUARDED_BY(m_mutex){false};
+    std::thread m_thread;
+};
+} // namespace node
+
+#endif // BITCOIN_NODE_BLOCKTEMPLATECACHE_H
@@ -33,7 +33,9 @@ class WalletLoader;
 } // namespace interfaces
 
 namespace node {
+class BlockTemplateCache;
 class KernelNotifications;
+class PoWAudit;
 
 //! NodeContext struct containing references to chain state and connection
 //! state.
@@ -58,6 +60,8 @@ struct NodeContext {
     std::unique_ptr<PeerManager> peerman;
     std::unique_ptr<ChainstateManager> chainman;
     std::unique_ptr<BanMan> banman;
+    std::unique_ptr<PoWAudit> pow_audit;
+    std::unique_ptr<BlockTemplateCache> block_template_cache;
     ArgsManager* args{nullptr}; // Currently a raw pointer because the memory is not managed by this struct
     std::vector<BaseIndex*> indexes; // raw pointers because memory is not managed by this struct
     std::unique_ptr<interfaces::Chain> chain;
@@ -14,6 +14,7 @@
 #include <consensus/merkle.h>
 #include <consensus/tx_verify.h>
 #include <consensus/validation.h>
+#include <crypto/common.h>
 #include <deploymentstatus.h>
 #include <logging.h>
 #include <policy/feerate.h>
@@ -25,7 +26,12 @@
 #include <validation.h>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <limits>
+#include <thread>
 #include <utility>
+#include <vector>
 
 namespace node {
 int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParams, const CBlockIndex* pindexPrev)
@@ -57,6 +63,65 @@ void RegenerateCommitments(CBlock& block, ChainstateManager& chainman)
     block.hashMerkleRoot = BlockMerkleRoot(block);
 }
 
+bool SolveBlockNonce(CBlockHeader& block, const Consensus::Params& params, uint64_t& max_tries, int threads, const std::function<bool()>& interrupted)
+{
+    const uint64_t start{block.nNonce};
+    // Like the single threaded search, never try the maximum nonce.
+    const uint64_t end{std::min<uint64_t>(start + std::min<uint64_t>(max_tries, std::numeric_limits<uint32_t>::max()), std::numeric_limits<uint32_t>::max())};
+
+    const std::array<unsigned char, BLOCK_HEADER_SIZE> header{block.SerializeToArray()};
+
+    // Threads claim chunks of nonces in increasing order and finish every
+    // chunk below the lowest solution found so far, so the result is the
+    // lowest solution no matter how many threads search.
+    std::atomic<uint64_t> next{start};
+    std::atomic<uint64_t> found{end};
+    std::atomic<bool> stop{false};
+    auto search{[&](yespower_local_t* local) {
+        std::array<unsigned char, BLOCK_HEADER_SIZE> thread_header{header};
+        while (!stop) {
+            const uint64_t chunk_begin{next.fetch_add(NONCE_SEARCH_CHUNK_SIZE)};
+            const uint64_t chunk_end{std::min<uint64_t>(chunk_begin + NONCE_SEARCH_CHUNK_SIZE, found)};
+            if (chunk_begin >= chunk_end) break;
+            for (uint64_t nonce = chunk_begin; nonce < chunk_end && nonce < found; ++nonce) {
+                if (interrupted()) {
+                    stop = true;
+                    break;
+                }
+                WriteLE32(thread_header.data() + BLOCK_HEADER_NONCE_OFFSET, nonce);
+                if (CheckProofOfWork(GetSerializedHeaderPoWHash(thread_header, local), block.nBits, params)) {
+                    uint64_t lowest{found};
+                    while (nonce < lowest && !found.compare_exchange_weak(lowest, nonce)) {}
+                    break;
+                }
+            }
+        }
+    }};
+
+    // The calling thread searches too, in its own yespower_tls() region. The
+    // workers only live for this call, so each hashes in a local region that
+    // is freed when it is done rather than in a yespower_tls() region that
+    // would never be.
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threads; ++i) {
+        workers.emplace_back([&] {
+            yespower_local_t local;
+            if (yespower_init_local(&local)) return;
+            search(&local);
+            yespower_free_local(&local);
+        });
+    }
+    search(nullptr);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    if (stop) return false;
+
+    block.nNonce = found;
+    max_tries -= found - start;
+    return found < end;
+}
+
 static BlockAssembler::Options ClampOptions(BlockAssembler::Options options)
 {
     // Limit weight to between 4K and DEFAULT_BLOCK_MAX_WEIGHT for sanity:
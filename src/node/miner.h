@@ -10,6 +10,7 @@
 #include <primitives/block.h>
 #include <txmempool.h>
 
+#include <functional>
 #include <memory>
 #include <optional>
 #include <stdint.h>
@@ -31,6 +32,12 @@ namespace Consensus { struct Params; };
 
 namespace node {
 static const bool DEFAULT_PRINTPRIORITY = false;
+/** Default for -generatethreads, the number of threads the generate RPCs search for a nonce on */
+static constexpr int DEFAULT_GENERATE_THREADS{1};
+/** Maximum number of threads the generate RPCs search for a nonce on */
+static constexpr int MAX_GENERATE_THREADS{64};
+/** Number of consecutive nonces a nonce search thread claims at a time */
+static constexpr uint32_t NONCE_SEARCH_CHUNK_SIZE{16};
 
 struct CBlockTemplate
 {
@@ -204,6 +211,21 @@ int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParam
 /** Update an old GenerateCoinbaseCommitment from CreateNewBlock after the block txs have changed */
 void RegenerateCommitments(CBlock& block, ChainstateManager& chainman);
 
+/**
+ * Search for the lowest nonce, starting at block.nNonce, for which the block
+ * meets its proof-of-work target, on the given number of threads.
+ *
+ * At most max_tries nonces are tried, and never the maximum nonce. block.nNonce
+ * is set to the nonce found, or else to the first nonce not tried, and
+ * max_tries is decreased by the number of nonces before it, exactly like a
+ * search on a single thread would. The header is serialized once, and each
+ * thread only patches the nonce into its own copy.
+ *
+ * @returns whether a nonce was found. The search stops early, without a
+ *          meaningful result, once interrupted() returns true.
+ */
+bool SolveBlockNonce(CBlockHeader& block, const Consensus::Params& params, uint64_t& max_tries, int threads, const std::function<bool()>& interrupted);
+
 /** Apply -blockmintxfee and -blockmaxweight options from ArgsManager to BlockAssembler options. */
 void ApplyArgsManOptions(const ArgsManager& gArgs, BlockAssembler::Options& options);
 } // namespace node
@@ -0,0 +1,137 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/powaudit.h>
+
+#include <chain.h>
+#include <kernel/notifications_interface.h>
+#include <logging.h>
+#include <node/blockstorage.h>
+#include <pow.h>
+#include <primitives/block.h>
+#include <tinyformat.h>
+#include <util/batchpriority.h>
+#include <util/thread.h>
+#include <util/translation.h>
+#include <validation.h>
+
+#include <algorithm>
+#include <optional>
+
+namespace node {
+PoWAudit::~PoWAudit()
+{
+    Stop();
+}
+
+void PoWAudit::Start(int threads)
+{
+    assert(m_threads.empty());
+    {
+        LOCK(::cs_main);
+        for (const CBlockIndex* pindex : m_chainman.m_blockman.GetAllBlockIndices()) {
+            // The genesis block is never checked against its target.
+            if (pindex->pprev) m_entries.push_back(pindex);
+        }
+    }
+    // Audit the most recent blocks first, they are the most likely to be
+    // re-read by validation.
+    std::sort(m_entries.begin(), m_entries.end(), [](const CBlockIndex* a, const CBlockIndex* b) { return a->nHeight > b->nHeight; });
+
+    LogPrintf("PoW audit: checking %u block index entries using %d threads\n", m_entries.size(), threads);
+    m_running = threads;
+    for (int n = 0; n < threads; ++n) {
+        m_threads.emplace_back(&util::TraceThread, strprintf("powaudit.%i", n), [this] { ThreadAudit(); });
+    }
+}
+
+void PoWAudit::Stop()
+{
+    Interrupt();
+    for (std::thread& thread : m_threads) {
+        if (thread.joinable()) thread.join();
+    }
+    m_threads.clear();
+}
+
+PoWAudit::Progress PoWAudit::GetProgress() const
+{
+    LOCK(m_failed_mutex);
+    return Progress{
+        .running = m_running > 0,
+        .threads = static_cast<int>(m_threads.size()),
+        .total = m_entries.size(),
+        .checked = m_checked,
+        .failed = m_failed,
+    };
+}
+
+void PoWAudit::ThreadAudit()
+{
+    ScheduleBatchPriority();
+
+    // The audit threads only live until the audit is done, so hash in a local
+    // region that is freed then rather than in a yespower_tls() region that
+    // would never be. yespower_init_local() cannot fail, but fall back to the
+    // yespower_tls() region if it ever does.
+    yespower_local_t local;
+    const bool have_local{yespower_init_local(&local) == 0};
+
+    struct Entry {
+        const CBlockIndex* pindex;
+        CBlockHeader header;
+        std::optional<uint256> cached_pow_hash;
+    };
+    std::vector<Entry> batch;
+    batch.reserve(POW_AUDIT_BATCH_SIZE);
+    while (!m_interrupt) {
+        const size_t begin{m_next.fetch_add(POW_AUDIT_BATCH_SIZE)};
+        if (begin >= m_entries.size()) break;
+        const size_t end{std::min(begin + POW_AUDIT_BATCH_SIZE, m_entries.size())};
+
+        batch.clear();
+        {
+            LOCK(::cs_main);
+            for (size_t i = begin; i < end; ++i) {
+                const CBlockIndex* pindex{m_entries[i]};
+                std::optional<uint256> cached_pow_hash{GetMemoizedPoWHash(pindex->GetBlockHash())};
+                uint256 stored_pow_hash;
+                if (!cached_pow_hash && m_chainman.m_blockman.PersistPoWHashes() &&
+                    m_chainman.m_blockman.m_block_tree_db->ReadBlockPoWHash(pindex->GetBlockHash(), stored_pow_hash)) {
+                    cached_pow_hash = stored_pow_hash;
+                }
+                batch.push_back({pindex, pindex->GetBlockHeader(), cached_pow_hash});
+            }
+        }
+
+        for (const auto& [pindex, header, cached_pow_hash] : batch) {
+            if (m_interrupt) break;
+            // Always hash the header fields, never look up the memo.
+            const uint256 pow_hash{GetSerializedHeaderPoWHash(header.SerializeToArray(), have_local ? &local : nullptr)};
+            const bool cache_mismatch{cached_pow_hash && *cached_pow_hash != pow_hash};
+            if (cache_mismatch || !CheckProofOfWork(pow_hash, header.nBits, m_chainman.GetConsensus())) {
+                LogPrintf("ERROR: PoW audit: %s for block index entry %s\n",
+                          cache_mismatch ? "cached PoW hash mismatch" : "CheckProofOfWork failed", pindex->ToString());
+                bool first_failure;
+                {
+                    LOCK(m_failed_mutex);
+                    first_failure = m_failed.empty();
+                    m_failed.push_back(pindex->GetBlockHash());
+                }
+                if (first_failure) {
+                    m_chainman.GetNotifications().warning(_("The proof-of-work audit found corrupted block index entries. Consider running with -reindex."));
+                }
+            }
+            ++m_checked;
+        }
+    }
+
+    if (have_local) yespower_free_local(&local);
+
+    if (--m_running == 0) {
+        LogPrintf("PoW audit: %s after checking %u of %u block index entries, %u failed\n",
+                  m_interrupt ? "interrupted" : "finished", m_checked.load(), m_entries.size(), WITH_LOCK(m_failed_mutex, return m_failed.size()));
+    }
+}
+} // namespace node
@@ -0,0 +1,81 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_POWAUDIT_H
+#define BITCOIN_NODE_POWAUDIT_H
+
+#include <kernel/cs_main.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+class CBlockIndex;
+class ChainstateManager;
+
+namespace node {
+/** Default for -auditpow, the number of PoW audit threads (0 = no audit) */
+static constexpr int DEFAULT_AUDITPOW_THREADS{0};
+/** Maximum number of PoW audit threads */
+static constexpr int MAX_AUDITPOW_THREADS{16};
+/** Number of block index entries an audit thread claims at a time */
+static constexpr size_t POW_AUDIT_BATCH_SIZE{64};
+
+/**
+ * Re-derives the PoW hash of every block index entry loaded from disk on a
+ * pool of low priority background threads. Each hash is checked against the
+ * target of its entry, and against the hash memoized or stored for it (with
+ * -persistpowhashes), to detect corruption of the block index database.
+ *
+ * cs_main is only held to copy a batch of headers, so the audit does not
+ * hold up validation.
+ */
+class PoWAudit
+{
+public:
+    struct Progress {
+        bool running;
+        int threads;
+        size_t total;
+        size_t checked;
+        std::vector<uint256> failed;
+    };
+
+    explicit PoWAudit(ChainstateManager& chainman) : m_chainman{chainman} {}
+    ~PoWAudit();
+
+    /** Snapshot the block index and start the audit threads. */
+    void Start(int threads) EXCLUSIVE_LOCKS_REQUIRED(!::cs_main);
+    /** Ask the audit threads to stop after the hash they are working on. */
+    void Interrupt() { m_interrupt = true; }
+    /** Interrupt the audit and join its threads. */
+    void Stop();
+
+    Progress GetProgress() const EXCLUSIVE_LOCKS_REQUIRED(!m_failed_mutex);
+
+private:
+    void ThreadAudit() EXCLUSIVE_LOCKS_REQUIRED(!::cs_main, !m_failed_mutex);
+
+    ChainstateManager& m_chainman;
+
+    //! Entries to audit. Block index entries are never deleted, so the
+    //! pointers stay valid for the lifetime of the ChainstateManager.
+    std::vector<const CBlockIndex*> m_entries;
+    //! Index of the next entry to be claimed by an audit thread.
+    std::atomic<size_t> m_next{0};
+    std::atomic<size_t> m_checked{0};
+    std::atomic<int> m_running{0};
+    std::atomic<bool> m_interrupt{false};
+
+    mutable Mutex m_failed_mutex;
+    std::vector<uint256> m_failed GUARDED_BY(m_failed_mutex);
+
+    std::vector<std::thread> m_threads;
+};
+} // namespace node
+
+#endif // BITCOIN_NODE_POWAUDIT_H
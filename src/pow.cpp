@@ -10,6 +10,9 @@
 #include <primitives/block.h>
 #include <uint256.h>
 
+#include <algorithm>
+#include <vector>
+
 unsigned int GetNextWorkRequired(const CBlockIndex* pindexLast, const CBlockHeader *pblock, const Consensus::Params& params)
 {
 	
@@ -104,6 +107,9 @@ unsigned int CalculateNextWorkRequired(const CBlockIndex* pindexLast, int64_t nF
 //  to prevent 33% Sybil attack that can manipulate difficulty via timestamps. See:
 // https://github.com/zcash/zcash/issues/4021
 
+//! Number of blocks at the start of the chain that get the PoW limit as target.
+static constexpr int64_t LWMA3_LOW_DIFF_BLOCKS{1000};
+
 unsigned int Lwma3CalculateNextWorkRequired(const CBlockIndex* pindexLast, const Consensus::Params& params)
 {
     const int64_t T = params.nPowTargetSpacing;
@@ -124,7 +130,7 @@ unsigned int Lwma3CalculateNextWorkRequired(const CBlockIndex* pindexLast, const
     const int64_t N = params.lwmaAveragingWindow;
 	
 	// Low diff blocks for diff initiation.
-	const int64_t L = 1000;
+	const int64_t L = LWMA3_LOW_DIFF_BLOCKS;
 
     // Define a k that will be used to get a proper average after weighting the solvetimes.
     const int64_t k = N * (N + 1) * T / 2; 
@@ -174,6 +180,87 @@ unsigned int Lwma3CalculateNextWorkRequired(const CBlockIndex* pindexLast, const
     return nextTarget.GetCompact();
 }
 
+void Lwma3Window::Push(const CBlockIndex& block, int64_t previous_timestamp)
+{
+    const int64_t T{m_params.nPowTargetSpacing};
+    const int64_t N{m_params.lwmaAveragingWindow};
+    const int64_t k{N * (N + 1) * T / 2};
+
+    Entry entry;
+    entry.time = block.GetBlockTime();
+    entry.timestamp = entry.time > previous_timestamp ? entry.time : previous_timestamp + 1;
+    entry.solvetime = std::min(6 * T, entry.timestamp - previous_timestamp);
+    arith_uint256 target;
+    target.SetCompact(block.nBits);
+    entry.target_share = target / N / k;
+
+    // The new block gets weight N, every other block in the window had its
+    // weight lowered by one by the caller.
+    m_sum_target_shares += entry.target_share;
+    m_sum_solvetimes += entry.solvetime;
+    m_sum_weighted_solvetimes += entry.solvetime * N;
+    m_entries.push_back(entry);
+}
+
+bool Lwma3Window::Slide(const CBlockIndex& block)
+{
+    const Entry& oldest{m_entries.front()};
+    // The oldest block becomes the anchor of the window, with its own
+    // timestamp. If that is not the one its solvetime was computed with, the
+    // solvetimes of the remaining blocks change too.
+    if (oldest.timestamp != oldest.time) return false;
+
+    const int64_t previous_timestamp{m_entries.back().timestamp};
+    m_sum_weighted_solvetimes -= m_sum_solvetimes;
+    m_sum_solvetimes -= oldest.solvetime;
+    // Subtraction is exact modulo 2^256, like the additions of the loop.
+    m_sum_target_shares -= oldest.target_share;
+    m_entries.pop_front();
+    Push(block, previous_timestamp);
+    return true;
+}
+
+void Lwma3Window::Rebuild(const CBlockIndex& last)
+{
+    const int64_t N{m_params.lwmaAveragingWindow};
+    std::vector<const CBlockIndex*> blocks(N);
+    const CBlockIndex* block{&last};
+    for (int64_t i = N - 1; i >= 0; --i) {
+        blocks[i] = block;
+        block = block->pprev;
+    }
+
+    m_entries.clear();
+    m_sum_target_shares = 0;
+    m_sum_solvetimes = 0;
+    m_sum_weighted_solvetimes = 0;
+    int64_t previous_timestamp{block->GetBlockTime()};
+    for (const CBlockIndex* entry_block : blocks) {
+        m_sum_weighted_solvetimes -= m_sum_solvetimes;
+        Push(*entry_block, previous_timestamp);
+        previous_timestamp = m_entries.back().timestamp;
+    }
+    // Push() weighs each block N, and every later block lowered the weight of
+    // the earlier ones by one, so the weights are 1..N as in the loop.
+}
+
+unsigned int Lwma3Window::NextWorkRequired(const CBlockIndex* pindexLast)
+{
+    const arith_uint256 powLimit = UintToArith256(m_params.powLimit);
+    if (pindexLast->nHeight <= LWMA3_LOW_DIFF_BLOCKS) return powLimit.GetCompact();
+
+    if (pindexLast != m_tip) {
+        if (!m_tip || pindexLast->pprev != m_tip || !Slide(*pindexLast)) {
+            Rebuild(*pindexLast);
+        }
+        m_tip = pindexLast;
+    }
+
+    arith_uint256 nextTarget = m_sum_target_shares * m_sum_weighted_solvetimes;
+    if (nextTarget > powLimit) { nextTarget = powLimit; }
+
+    return nextTarget.GetCompact();
+}
 
 // Check that on difficulty adjustments, the new difficulty does not increase
 // or decrease beyond the permitted limits.
@@ -6,8 +6,10 @@
 #ifndef BITCOIN_POW_H
 #define BITCOIN_POW_H
 
+#include <arith_uint256.h>
 #include <consensus/params.h>
 
+#include <deque>
 #include <stdint.h>
 
 class CBlockHeader;
@@ -21,6 +23,50 @@ unsigned int CalculateNextWorkRequired(const CBlockIndex* pindexLast, int64_t nF
 
 unsigned int Lwma3CalculateNextWorkRequired(const CBlockIndex* pindexLast, const Consensus::Params& params);
 
+/**
+ * Incremental version of Lwma3CalculateNextWorkRequired(), with bit-identical
+ * results.
+ *
+ * The running sums of the averaging window are kept for the last chain tip
+ * asked about. When the next tip extends it, the oldest block leaves the
+ * window and the new one enters it in O(1). Any other tip, or a window whose
+ * oldest block had its timestamp raised to keep solvetimes positive (which
+ * would change every solvetime once it becomes the anchor), rebuilds the
+ * window by walking pprev, without GetAncestor() skip list lookups.
+ *
+ * Not thread safe; the caller must serialize access.
+ */
+class Lwma3Window
+{
+public:
+    explicit Lwma3Window(const Consensus::Params& params) : m_params{params} {}
+
+    unsigned int NextWorkRequired(const CBlockIndex* pindexLast);
+
+private:
+    struct Entry {
+        //! Block timestamp, and the one used for solvetimes (raised to one
+        //! second after the previous one if it is not past it).
+        int64_t time;
+        int64_t timestamp;
+        int64_t solvetime;
+        //! Target of the block, divided by N and k.
+        arith_uint256 target_share;
+    };
+
+    void Push(const CBlockIndex& block, int64_t previous_timestamp);
+    bool Slide(const CBlockIndex& block);
+    void Rebuild(const CBlockIndex& last);
+
+    const Consensus::Params& m_params;
+    const CBlockIndex* m_tip{nullptr};
+    //! The N blocks ending at m_tip, oldest first.
+    std::deque<Entry> m_entries;
+    arith_uint256 m_sum_target_shares;
+    int64_t m_sum_solvetimes{0};
+    int64_t m_sum_weighted_solvetimes{0};
+};
+
 
 /** Check whether a block hash satisfies the proof-of-work requirement specified by nBits */
 bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params&);
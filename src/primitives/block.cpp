@@ -5,24 +5,38 @@
 
 #include <primitives/block.h>
 
+#include <crypto/common.h>
 #include <hash.h>
 #include <tinyformat.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+
 /* yespower algo */
 
 #include <crypto/yespower-1.0.1/yespower.h>
-#include <streams.h>
-#include <version.h>
 #include <stdlib.h> // exit()
-#include <sync.h>
 
-uint256 CBlockHeaderUncached::GetHash() const
+std::array<unsigned char, BLOCK_HEADER_SIZE> CBlockHeader::SerializeToArray() const
+{
+    std::array<unsigned char, BLOCK_HEADER_SIZE> header;
+    WriteLE32(header.data(), static_cast<uint32_t>(nVersion));
+    std::copy(hashPrevBlock.begin(), hashPrevBlock.end(), header.begin() + 4);
+    std::copy(hashMerkleRoot.begin(), hashMerkleRoot.end(), header.begin() + 36);
+    WriteLE32(header.data() + 68, nTime);
+    WriteLE32(header.data() + 72, nBits);
+    WriteLE32(header.data() + BLOCK_HEADER_NONCE_OFFSET, nNonce);
+    return header;
+}
+
+uint256 CBlockHeader::GetHash() const
 {
-    return (CHashWriter{PROTOCOL_VERSION} << *this).GetHash();
+    return Hash(SerializeToArray());
 }
 
 /* YespowerSugar */
-uint256 CBlockHeaderUncached::GetPoWHash() const
+uint256 GetSerializedHeaderPoWHash(Span<const unsigned char> header, yespower_local_t* local)
 {
     static const yespower_params_t yespower_1_0_sugarchain = {
         .version = YESPOWER_1_0,
@@ -32,35 +46,122 @@ uint256 CBlockHeaderUncached::GetPoWHash() const
         .perslen = 0
     };
     uint256 hash;
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    ss << *this;
-    if (yespower_tls((const uint8_t *)&ss[0], ss.size(), &yespower_1_0_sugarchain, (yespower_binary_t *)&hash)) {
-        tfm::format(std::cerr, "Error: CBlockHeaderUncached::GetPoWHash(): failed to compute PoW hash (out of memory?)\n");
+    const int ret{local ? yespower(local, header.data(), header.size(), &yespower_1_0_sugarchain, (yespower_binary_t *)&hash) :
+                          yespower_tls(header.data(), header.size(), &yespower_1_0_sugarchain, (yespower_binary_t *)&hash)};
+    if (ret) {
+        tfm::format(std::cerr, "Error: GetSerializedHeaderPoWHash(): failed to compute PoW hash (out of memory?)\n");
         exit(1);
     }
     return hash;
 }
 
-/* YespowerSugar */
-uint256 CBlockHeader::GetPoWHash_cached() const
+uint256 CBlockHeader::GetPoWHash() const
+{
+    return GetSerializedHeaderPoWHash(SerializeToArray());
+}
+
+namespace {
+//! Number of PoW hash memo sets, a power of two.
+constexpr size_t POW_MEMO_SETS{1 << 14};
+//! Number of entries per PoW hash memo set. With 4 ways evicted oldest
+//! first, a full HEADERS message of 2000 hashes practically never evicts
+//! one of its own entries.
+constexpr size_t POW_MEMO_WAYS{4};
+
+/**
+ * A memo slot holding a block hash and its PoW hash, guarded by a sequence
+ * lock: a writer makes the sequence number odd while it updates the words,
+ * and a reader that sees an odd or changed sequence number treats the slot
+ * as a miss. All accesses are atomic, so no thread ever blocks.
+ */
+struct PoWMemoSlot {
+    std::atomic<uint64_t> seq{0};
+    //! Value of g_pow_memo_clock when the slot was last written, so the
+    //! oldest entry of a set is the one evicted.
+    std::atomic<uint64_t> stamp{0};
+    std::array<std::atomic<uint64_t>, 8> words{};
+
+    /** Read the block hash (words 0-3) and PoW hash (words 4-7). Returns
+     *  false if a writer was active. */
+    bool Read(uint64_t (&out)[8]) const
+    {
+        const uint64_t seq_before{seq.load(std::memory_order_acquire)};
+        if (seq_before & 1) return false;
+        for (size_t i = 0; i < 8; ++i) {
+            out[i] = words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return seq.load(std::memory_order_relaxed) == seq_before;
+    }
+};
+
+PoWMemoSlot g_pow_memo[POW_MEMO_SETS][POW_MEMO_WAYS];
+std::atomic<uint64_t> g_pow_memo_clock{0};
+
+void ToWords(const uint256& hash, uint64_t* words)
+{
+    for (size_t i = 0; i < 4; ++i) {
+        words[i] = ReadLE64(hash.begin() + 8 * i);
+    }
+}
+} // namespace
+
+std::optional<uint256> GetMemoizedPoWHash(const uint256& block_hash)
+{
+    uint64_t key[4];
+    ToWords(block_hash, key);
+    for (const PoWMemoSlot& slot : g_pow_memo[key[0] & (POW_MEMO_SETS - 1)]) {
+        uint64_t words[8];
+        if (!slot.Read(words) || !std::equal(key, key + 4, words)) continue;
+        uint256 pow_hash;
+        for (size_t i = 0; i < 4; ++i) {
+            WriteLE64(pow_hash.begin() + 8 * i, words[4 + i]);
+        }
+        return pow_hash;
+    }
+    return std::nullopt;
+}
+
+void MemoizePoWHash(const uint256& block_hash, const uint256& pow_hash)
 {
-    uint256 block_hash = GetHash();
-    LOCK(cache_lock);
-    if (cache_init) {
-        if (block_hash != cache_block_hash) {
-            tfm::format(std::cerr, "Error: CBlockHeader::GetPoWHash_cached(): block hash changed unexpectedly\n");
-            exit(1);
+    uint64_t key[4];
+    ToWords(block_hash, key);
+    auto& set{g_pow_memo[key[0] & (POW_MEMO_SETS - 1)]};
+
+    // Reuse the slot of this block hash, otherwise evict the oldest entry
+    // (empty slots have never been stamped).
+    PoWMemoSlot* victim{&set[0]};
+    for (PoWMemoSlot& slot : set) {
+        uint64_t words[8];
+        if (slot.Read(words) && std::equal(key, key + 4, words)) {
+            victim = &slot;
+            break;
         }
-        /* yespower PoW cache log: O (cyan) = HIT */
-        // printf("\033[36;1mO\033[0m block = %s PoW = %s\n", cache_block_hash.ToString().c_str(), cache_PoW_hash.ToString().c_str());
-    } else {
-        cache_PoW_hash = GetPoWHash();
-        cache_block_hash = block_hash;
-        cache_init = true;
-        /* yespower PoW cache log: x = MISS */
-        // printf("x block = %s PoW = %s\n", cache_block_hash.ToString().c_str(), cache_PoW_hash.ToString().c_str());
+        if (slot.stamp.load(std::memory_order_relaxed) < victim->stamp.load(std::memory_order_relaxed)) victim = &slot;
+    }
+
+    uint64_t seq{victim->seq.load(std::memory_order_relaxed)};
+    // Rather than waiting for a concurrent writer of the same slot, drop this entry.
+    if ((seq & 1) || !victim->seq.compare_exchange_strong(seq, seq + 1, std::memory_order_relaxed)) return;
+    std::atomic_thread_fence(std::memory_order_release);
+    uint64_t value[4];
+    ToWords(pow_hash, value);
+    for (size_t i = 0; i < 4; ++i) {
+        victim->words[i].store(key[i], std::memory_order_relaxed);
+        victim->words[4 + i].store(value[i], std::memory_order_relaxed);
     }
-    return cache_PoW_hash;
+    victim->stamp.store(++g_pow_memo_clock, std::memory_order_relaxed);
+    victim->seq.store(seq + 2, std::memory_order_release);
+}
+
+/* YespowerSugar */
+uint256 CBlockHeader::GetPoWHash_cached() const
+{
+    const uint256 block_hash{GetHash()};
+    if (const auto pow_hash{GetMemoizedPoWHash(block_hash)}) return *pow_hash;
+    const uint256 pow_hash{GetPoWHash()};
+    MemoizePoWHash(block_hash, pow_hash);
+    return pow_hash;
 }
 
 std::string CBlock::ToString() const
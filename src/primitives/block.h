@@ -6,11 +6,21 @@
 #ifndef BITCOIN_PRIMITIVES_BLOCK_H
 #define BITCOIN_PRIMITIVES_BLOCK_H
 
+#include <crypto/yespower-1.0.1/yespower.h>
 #include <primitives/transaction.h>
 #include <serialize.h>
+#include <span.h>
 #include <uint256.h>
 #include <util/time.h>
-#include <sync.h>
+
+#include <array>
+#include <cstddef>
+#include <optional>
+
+/** Size of a serialized block header */
+static constexpr size_t BLOCK_HEADER_SIZE{80};
+/** Offset of nNonce in a serialized block header */
+static constexpr size_t BLOCK_HEADER_NONCE_OFFSET{76};
 
 /** Nodes collect new transactions into a block, hash them into a hash tree,
  * and scan through nonce values to make the block's hash satisfy proof-of-work
@@ -19,7 +29,7 @@
  * in the block is a special one that creates a new coin owned by the creator
  * of the block.
  */
-class CBlockHeaderUncached
+class CBlockHeader
 {
 public:
     // header
@@ -30,12 +40,12 @@ public:
     uint32_t nBits;
     uint32_t nNonce;
 
-    CBlockHeaderUncached()
+    CBlockHeader()
     {
         SetNull();
     }
 
-    SERIALIZE_METHODS(CBlockHeaderUncached, obj) { READWRITE(obj.nVersion, obj.hashPrevBlock, obj.hashMerkleRoot, obj.nTime, obj.nBits, obj.nNonce); }
+    SERIALIZE_METHODS(CBlockHeader, obj) { READWRITE(obj.nVersion, obj.hashPrevBlock, obj.hashMerkleRoot, obj.nTime, obj.nBits, obj.nNonce); }
 
     void SetNull()
     {
@@ -52,10 +62,19 @@ public:
         return (nBits == 0);
     }
 
+    /** Serialize the header into a fixed-size buffer, without allocating. */
+    std::array<unsigned char, BLOCK_HEADER_SIZE> SerializeToArray() const;
+
     uint256 GetHash() const;
 
+    /** Compute the yespower hash of the header. */
     uint256 GetPoWHash() const;
 
+    /* YespowerSugar */
+    /** Like GetPoWHash(), but look the hash up in (and add it to) the
+     *  process-wide PoW hash memo first, see GetMemoizedPoWHash(). */
+    uint256 GetPoWHash_cached() const;
+
     NodeSeconds Time() const
     {
         return NodeSeconds{std::chrono::seconds{nTime}};
@@ -67,35 +86,23 @@ public:
     }
 };
 
-/* YespowerSugar */
-class CBlockHeader : public CBlockHeaderUncached
-{
-public:
-    mutable RecursiveMutex cache_lock; // Do not use CCriticalSection // See https://github.com/bitcoin/bitcoin/pull/17891
-    mutable bool cache_init;
-    mutable uint256 cache_block_hash, cache_PoW_hash;
+/** Compute the yespower hash of a serialized block header, e.g. to try many
+ *  nonces without serializing the header again for each. Hashes in the given
+ *  region, or in the calling thread's yespower_tls() region if none is given.
+ *  A yespower_tls() region is never freed, so short-lived threads should pass
+ *  a region of their own. */
+uint256 GetSerializedHeaderPoWHash(Span<const unsigned char> header, yespower_local_t* local = nullptr);
 
-    CBlockHeader()
-    {
-        cache_init = false;
-    }
-
-    CBlockHeader(const CBlockHeader& header)
-    {
-        *this = header;
-    }
-
-    CBlockHeader& operator=(const CBlockHeader& header)
-    {
-        *(CBlockHeaderUncached*)this = (CBlockHeaderUncached)header;
-        cache_init = header.cache_init;
-        cache_block_hash = header.cache_block_hash;
-        cache_PoW_hash = header.cache_PoW_hash;
-        return *this;
-    }
-
-    uint256 GetPoWHash_cached() const;
-};
+/* YespowerSugar */
+/**
+ * The PoW hash of a block is checked more than once (e.g. for its header
+ * during headers sync and again when the block arrives), and yespower is
+ * expensive. Recently computed PoW hashes are therefore kept in a fixed-size
+ * (64k entries), lock-free, set-associative memo keyed by block hash, rather
+ * than in every header. When a set is full, a new entry replaces its oldest one.
+ */
+std::optional<uint256> GetMemoizedPoWHash(const uint256& block_hash);
+void MemoizePoWHash(const uint256& block_hash, const uint256& pow_hash);
 
 class CBlock : public CBlockHeader
 {
@@ -105,6 +112,7 @@ public:
 
     // memory only
     mutable bool fChecked;
+    mutable bool m_checked_witness_commitment;
 
     CBlock()
     {
@@ -127,6 +135,7 @@ public:
         CBlockHeader::SetNull();
         vtx.clear();
         fChecked = false;
+        m_checked_witness_commitment = false;
     }
 
     CBlockHeader GetBlockHeader() const
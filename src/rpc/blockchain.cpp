@@ -26,6 +26,7 @@
 #include <net_processing.h>
 #include <node/blockstorage.h>
 #include <node/context.h>
+#include <node/powaudit.h>
 #include <node/transaction.h>
 #include <node/utxo_snapshot.h>
 #include <primitives/transaction.h>
@@ -2811,6 +2812,95 @@ const std::vector<RPCResult> RPCHelpForChainstate{
     {RPCResult::Type::BOOL, "validated", "whether the chainstate is fully validated. True if all blocks in the chainstate were validated, false if the chain is based on a snapshot and the snapshot has not yet been validated."},
 };
 
+static RPCHelpMan getpowauditinfo()
+{
+    return RPCHelpMan{"getpowauditinfo",
+        "\nReturns the progress of the block index proof-of-work audit started with -auditpow.\n",
+        {},
+        RPCResult{
+            RPCResult::Type::OBJ, "", "",
+            {
+                {RPCResult::Type::BOOL, "running", "whether the audit threads are still running"},
+                {RPCResult::Type::NUM, "threads", "the number of audit threads"},
+                {RPCResult::Type::NUM, "total", "the number of block index entries to check"},
+                {RPCResult::Type::NUM, "checked", "the number of block index entries checked so far"},
+                {RPCResult::Type::NUM, "progress", "the fraction of block index entries checked so far"},
+                {RPCResult::Type::ARR, "failed", "hashes of the blocks whose proof of work failed the check",
+                    {{RPCResult::Type::STR_HEX, "", "block hash"}}},
+            }},
+        RPCExamples{
+            HelpExampleCli("getpowauditinfo", "")
+            + HelpExampleRpc("getpowauditinfo", "")
+        },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const NodeContext& node = EnsureAnyNodeContext(request.context);
+    if (!node.pow_audit) {
+        throw JSONRPCError(RPC_MISC_ERROR, "The proof-of-work audit is not enabled. Use -auditpow=<n>.");
+    }
+    const node::PoWAudit::Progress progress{node.pow_audit->GetProgress()};
+
+    UniValue failed(UniValue::VARR);
+    for (const uint256& hash : progress.failed) {
+        failed.push_back(hash.GetHex());
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("running", progress.running);
+    ret.pushKV("threads", progress.threads);
+    ret.pushKV("total", (uint64_t)progress.total);
+    ret.pushKV("checked", (uint64_t)progress.checked);
+    ret.pushKV("progress", progress.total ? (double)progress.checked / progress.total : 1.0);
+    ret.pushKV("failed", failed);
+    return ret;
+},
+    };
+}
+
+static RPCHelpMan getcoinsprefetchinfo()
+{
+    return RPCHelpMan{"getcoinsprefetchinfo",
+        "\nReturns statistics on reading the coins spent by received blocks ahead of connecting them, see -prefetchthreads.\n",
+        {},
+        RPCResult{
+            RPCResult::Type::OBJ, "", "",
+            {
+                {RPCResult::Type::NUM, "threads", "the number of prefetching threads"},
+                {RPCResult::Type::NUM, "blocks", "the number of blocks whose coins were prefetched"},
+                {RPCResult::Type::NUM, "prevouts", "the number of coins spent by those blocks, without the ones created in the same block"},
+                {RPCResult::Type::NUM, "cached", "the number of those coins that were already in the cache"},
+                {RPCResult::Type::NUM, "warmed", "the number of coins read and added to the cache"},
+                {RPCResult::Type::NUM, "missing", "the number of coins not found in the database"},
+                {RPCResult::Type::NUM, "discarded", "the number of coins read but dropped because the cache was flushed meanwhile"},
+                {RPCResult::Type::NUM, "inputs", "the number of non-coinbase inputs of the connected blocks"},
+                {RPCResult::Type::NUM, "reads", "the number of coins the connected blocks still had to read from the database"},
+                {RPCResult::Type::NUM, "hitrate", "the fraction of inputs of the connected blocks that did not have to be read from the database"},
+            }},
+        RPCExamples{
+            HelpExampleCli("getcoinsprefetchinfo", "")
+            + HelpExampleRpc("getcoinsprefetchinfo", "")
+        },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    ChainstateManager& chainman = EnsureAnyChainman(request.context);
+    const CoinsPrefetchStats stats{WITH_LOCK(::cs_main, return chainman.m_prefetch_stats)};
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("threads", GetCoinsPrefetchWorkerThreads());
+    ret.pushKV("blocks", stats.blocks);
+    ret.pushKV("prevouts", stats.prevouts);
+    ret.pushKV("cached", stats.cached);
+    ret.pushKV("warmed", stats.warmed);
+    ret.pushKV("missing", stats.missing);
+    ret.pushKV("discarded", stats.discarded);
+    ret.pushKV("inputs", stats.inputs);
+    ret.pushKV("reads", stats.reads);
+    ret.pushKV("hitrate", stats.inputs ? 1.0 - std::min<double>(stats.reads, stats.inputs) / stats.inputs : 0.0);
+    return ret;
+},
+    };
+}
+
 static RPCHelpMan getchainstates()
 {
 return RPCHelpMan{
@@ -2896,6 +2986,8 @@ void RegisterBlockchainRPCCommands(CRPCTable& t)
         {"blockchain", &dumptxoutset},
         {"blockchain", &loadtxoutset},
         {"blockchain", &getchainstates},
+        {"blockchain", &getpowauditinfo},
+        {"blockchain", &getcoinsprefetchinfo},
         {"hidden", &invalidateblock},
         {"hidden", &reconsiderblock},
         {"hidden", &waitfornewblock},
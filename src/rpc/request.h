@@ -7,6 +7,7 @@
 #define BITCOIN_RPC_REQUEST_H
 
 #include <any>
+#include <functional>
 #include <string>
 
 #include <univalue.h>
@@ -25,6 +26,12 @@ void DeleteAuthCookie();
 /** Parse JSON-RPC batch reply into a vector */
 std::vector<UniValue> JSONRPCProcessBatchReply(const UniValue& in);
 
+/**
+ * Reply to a request with the result of a function, or with the error it
+ * throws. The function may be run on another thread.
+ */
+using RPCReplyFunction = std::function<void(std::function<UniValue()> fn)>;
+
 class JSONRPCRequest
 {
 public:
@@ -36,6 +43,12 @@ public:
     std::string authUser;
     std::string peerAddr;
     std::any context;
+    /**
+     * Set by servers that can reply after the handler returned. A handler
+     * calling it returns a null value, and replies through the returned
+     * function exactly once, from any thread.
+     */
+    std::function<RPCReplyFunction()> defer;
 
     void parse(const UniValue& valRequest);
 };
@@ -6,6 +6,7 @@
 
 #include <common/args.h>
 #include <net_processing.h>
+#include <node/blocktemplatecache.h>
 #include <node/context.h>
 #include <policy/fees.h>
 #include <rpc/protocol.h>
@@ -121,3 +122,11 @@ AddrMan& EnsureAnyAddrman(const std::any& context)
 {
     return EnsureAddrman(EnsureAnyNodeContext(context));
 }
+
+node::BlockTemplateCache& EnsureBlockTemplateCache(const NodeContext& node)
+{
+    if (!node.block_template_cache) {
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Block template cache not found");
+    }
+    return *node.block_template_cache;
+}
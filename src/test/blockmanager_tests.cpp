@@ -2,8 +2,10 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <arith_uint256.h>
 #include <chainparams.h>
 #include <clientversion.h>
+#include <dbwrapper.h>
 #include <node/blockstorage.h>
 #include <node/context.h>
 #include <node/kernel_notifications.h>
@@ -18,8 +20,11 @@
 
 using node::BLOCK_SERIALIZATION_HEADER_SIZE;
 using node::BlockManager;
+using node::BlockMap;
+using node::BlockTreeDB;
 using node::KernelNotifications;
 using node::MAX_BLOCKFILE_SIZE;
+using node::POW_HASH_BACKFILL_BATCH;
 
 // use BasicTestingSetup here for the data directory configuration, setup, and cleanup
 BOOST_FIXTURE_TEST_SUITE(blockmanager_tests, BasicTestingSetup)
@@ -201,4 +206,94 @@ BOOST_AUTO_TEST_CASE(blockmanager_flush_block_file)
     BOOST_CHECK_EQUAL(read_block.nVersion, 2);
 }
 
+BOOST_AUTO_TEST_CASE(blockmanager_pow_hash_persistence)
+{
+    const auto params{CreateChainParams(ArgsManager{}, ChainType::REGTEST)};
+    const Consensus::Params& consensus{params->GetConsensus()};
+    BlockTreeDB db{DBParams{.path = "", .cache_bytes = 1 << 20, .memory_only = true}};
+
+    BlockMap index;
+    auto add_entry{[&](const uint256& hash, CBlockIndex* prev) {
+        CBlockIndex& entry{index[hash]};
+        entry.phashBlock = &index.find(hash)->first;
+        entry.pprev = prev;
+        entry.nBits = UintToArith256(consensus.powLimit).GetCompact();
+        return &entry;
+    }};
+    auto lookup{[&](const uint256& hash) -> const CBlockIndex* {
+        const auto it{index.find(hash)};
+        return it == index.end() ? nullptr : &it->second;
+    }};
+    CBlockIndex* genesis{add_entry(uint256S("01"), nullptr)};
+    CBlockIndex* block1{add_entry(uint256S("02"), genesis)};
+    CBlockIndex* block2{add_entry(uint256S("03"), block1)};
+
+    LOCK(cs_main);
+    BOOST_CHECK(db.WriteBatchSync({}, 0, {genesis, block1, block2}, {{block1->GetBlockHash(), uint256{}}}));
+    uint256 pow_hash{uint256::ONE};
+    BOOST_CHECK(db.ReadBlockPoWHash(block1->GetBlockHash(), pow_hash));
+    BOOST_CHECK_EQUAL(pow_hash, uint256{});
+    BOOST_CHECK(!db.ReadBlockPoWHash(block2->GetBlockHash(), pow_hash));
+
+    std::vector<const CBlockIndex*> with_pow_hash;
+    BOOST_CHECK(db.LoadBlockPoWHashes(consensus, lookup, with_pow_hash, m_node.kernel->interrupt));
+    BOOST_CHECK(with_pow_hash == std::vector<const CBlockIndex*>{block1});
+
+    // A stored hash that does not meet the target of its block fails the load.
+    BOOST_CHECK(db.WriteBatchSync({}, 0, {}, {{block2->GetBlockHash(), uint256S("ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff")}}));
+    with_pow_hash.clear();
+    BOOST_CHECK(!db.LoadBlockPoWHashes(consensus, lookup, with_pow_hash, m_node.kernel->interrupt));
+}
+
+BOOST_AUTO_TEST_CASE(blockmanager_pow_hash_flush)
+{
+    const auto params{CreateChainParams(ArgsManager{}, ChainType::REGTEST)};
+    KernelNotifications notifications{m_node.exit_status};
+    const BlockManager::Options blockman_opts{
+        .chainparams = *params,
+        .persist_pow_hashes = true,
+        .blocks_dir = m_args.GetBlocksDirPath(),
+        .notifications = notifications,
+    };
+    BlockManager blockman{m_node.kernel->interrupt, blockman_opts};
+
+    CBlockHeader header{params->GenesisBlock()};
+    uint256 memoized_hash, backfilled_hash;
+    {
+        LOCK(cs_main);
+        blockman.m_block_tree_db = std::make_unique<BlockTreeDB>(DBParams{.path = "", .cache_bytes = 1 << 20, .memory_only = true});
+        CBlockIndex* best_header{nullptr};
+        blockman.AddToBlockIndex(header, best_header);
+
+        // The PoW hash memoized while checking a header is stored with it.
+        header.hashPrevBlock = header.GetHash();
+        header.nBits = UintToArith256(params->GetConsensus().powLimit).GetCompact();
+        memoized_hash = header.GetHash();
+        MemoizePoWHash(memoized_hash, uint256{});
+        blockman.AddToBlockIndex(header, best_header);
+
+        // One that is no longer memoized is left to BackfillPoWHashes().
+        ++header.nNonce;
+        backfilled_hash = header.GetHash();
+        BOOST_CHECK(!GetMemoizedPoWHash(backfilled_hash));
+        blockman.AddToBlockIndex(header, best_header);
+
+        BOOST_CHECK(blockman.WriteBlockIndexDB());
+        uint256 pow_hash{uint256::ONE};
+        BOOST_CHECK(blockman.m_block_tree_db->ReadBlockPoWHash(memoized_hash, pow_hash));
+        BOOST_CHECK_EQUAL(pow_hash, uint256{});
+        BOOST_CHECK(!blockman.m_block_tree_db->ReadBlockPoWHash(backfilled_hash, pow_hash));
+    }
+
+    // Use a memoized hash rather than computing one that misses the target.
+    MemoizePoWHash(backfilled_hash, uint256::ONE);
+    BOOST_CHECK_EQUAL(blockman.BackfillPoWHashes(POW_HASH_BACKFILL_BATCH), 1U);
+    BOOST_CHECK_EQUAL(blockman.BackfillPoWHashes(POW_HASH_BACKFILL_BATCH), 0U);
+    LOCK(cs_main);
+    BOOST_CHECK(blockman.WriteBlockIndexDB());
+    uint256 pow_hash;
+    BOOST_CHECK(blockman.m_block_tree_db->ReadBlockPoWHash(backfilled_hash, pow_hash));
+    BOOST_CHECK_EQUAL(pow_hash, uint256::ONE);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
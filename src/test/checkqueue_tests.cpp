@@ -55,6 +55,16 @@ struct FakeCheckCheckCompletion {
     }
 };
 
+struct SlowCheck {
+    static std::atomic<size_t> n_calls;
+    bool operator()()
+    {
+        UninterruptibleSleep(std::chrono::microseconds{100});
+        n_calls.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+};
+
 struct FailingCheck {
     bool fails;
     FailingCheck(bool _fails) : fails(_fails){};
@@ -142,11 +152,13 @@ std::condition_variable FrozenCleanupCheck::cv{};
 Mutex UniqueCheck::m;
 std::unordered_multiset<size_t> UniqueCheck::results;
 std::atomic<size_t> FakeCheckCheckCompletion::n_calls{0};
+std::atomic<size_t> SlowCheck::n_calls{0};
 std::atomic<size_t> MemoryCheck::fake_allocated_memory{0};
 
 // Queue Typedefs
 typedef CCheckQueue<FakeCheckCheckCompletion> Correct_Queue;
 typedef CCheckQueue<FakeCheck> Standard_Queue;
+typedef CCheckQueue<SlowCheck> Slow_Queue;
 typedef CCheckQueue<FailingCheck> Failing_Queue;
 typedef CCheckQueue<UniqueCheck> Unique_Queue;
 typedef CCheckQueue<MemoryCheck> Memory_Queue;
@@ -156,10 +168,10 @@ typedef CCheckQueue<FrozenCleanupCheck> FrozenCleanup_Queue;
 /** This test case checks that the CCheckQueue works properly
  * with each specified size_t Checks pushed.
  */
-static void Correct_Queue_range(std::vector<size_t> range)
+static void Correct_Queue_range(std::vector<size_t> range, int threads_num = SCRIPT_CHECK_THREADS)
 {
     auto small_queue = std::make_unique<Correct_Queue>(QUEUE_BATCH_SIZE);
-    small_queue->StartWorkerThreads(SCRIPT_CHECK_THREADS);
+    small_queue->StartWorkerThreads(threads_num);
     // Make vChecks here to save on malloc (this test can be slow...)
     std::vector<FakeCheckCheckCompletion> vChecks;
     vChecks.reserve(9);
@@ -213,6 +225,20 @@ BOOST_AUTO_TEST_CASE(test_CheckQueue_Correct_Random)
         range.push_back(i);
     Correct_Queue_range(range);
 }
+/** Test that checks are correct when most workers have to steal from others
+ */
+BOOST_AUTO_TEST_CASE(test_CheckQueue_Correct_ManyThreads)
+{
+    std::vector<size_t> range{1, 2, 63, 64, 1000, 100000};
+    Correct_Queue_range(range, /*threads_num=*/63);
+}
+/** Test that the master does all the checks when there are no workers
+ */
+BOOST_AUTO_TEST_CASE(test_CheckQueue_Correct_NoThreads)
+{
+    std::vector<size_t> range{1, 1000};
+    Correct_Queue_range(range, /*threads_num=*/0);
+}
 
 
 /** Test that failing checks are caught */
@@ -364,6 +390,27 @@ BOOST_AUTO_TEST_CASE(test_CheckQueue_FrozenCleanup)
     queue->StopWorkerThreads();
 }
 
+// Test that the master does not return while workers, which are being
+// stopped, are still running checks.
+BOOST_AUTO_TEST_CASE(test_CheckQueue_StopWhileWaiting)
+{
+    auto queue = std::make_unique<Slow_Queue>(QUEUE_BATCH_SIZE);
+    queue->StartWorkerThreads(SCRIPT_CHECK_THREADS);
+    const size_t COUNT = 10000;
+    SlowCheck::n_calls = 0;
+    {
+        CCheckQueueControl<SlowCheck> control(queue.get());
+        control.Add(std::vector<SlowCheck>(COUNT));
+        std::thread stopper([&] {
+            UninterruptibleSleep(std::chrono::milliseconds{10});
+            queue->StopWorkerThreads();
+        });
+        BOOST_CHECK(control.Wait());
+        BOOST_CHECK_EQUAL(SlowCheck::n_calls, COUNT);
+        stopper.join();
+    }
+    BOOST_CHECK_EQUAL(SlowCheck::n_calls, COUNT);
+}
 
 /** Test that CCheckQueueControl is threadsafe */
 BOOST_AUTO_TEST_CASE(test_CheckQueueControl_Locks)
@@ -6,7 +6,7 @@
 #include <clientversion.h>
 #include <coins.h>
 #include <streams.h>
-#include <test/util/poolresourcetester.h>
+#include <test/util/coins.h>
 #include <test/util/random.h>
 #include <test/util/setup_common.h>
 #include <txdb.h>
@@ -282,6 +282,48 @@ BOOST_AUTO_TEST_CASE(coins_cache_simulation_test)
 
     CCoinsViewDB db_base{{.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {}};
     SimulationTest(&db_base, true);
+
+    CCoinsViewDB writer_db{{.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {}};
+    CCoinsViewBackgroundWriter writer_base{&writer_db};
+    SimulationTest(&writer_base, true);
+}
+
+BOOST_AUTO_TEST_CASE(coins_background_writer)
+{
+    CCoinsViewDB db{{.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {}};
+    CCoinsViewBackgroundWriter writer{&db};
+    CCoinsViewCacheTest cache{&writer};
+
+    std::vector<COutPoint> outpoints;
+    for (int i = 0; i < 1000; ++i) {
+        outpoints.push_back(AddTestCoin(cache));
+    }
+    const uint256 block{InsecureRand256()};
+    cache.SetBestBlock(block);
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK(cache.map().empty());
+
+    // Whether or not the write is done yet, the coins can be read.
+    BOOST_CHECK(writer.GetBestBlock() == block);
+    for (const COutPoint& outpoint : outpoints) {
+        BOOST_CHECK(cache.HaveCoin(outpoint));
+    }
+
+    // Spending them writes after the previous write.
+    for (size_t i = 0; i < outpoints.size(); i += 2) {
+        BOOST_CHECK(cache.SpendCoin(outpoints[i]));
+    }
+    const uint256 block2{InsecureRand256()};
+    cache.SetBestBlock(block2);
+    BOOST_CHECK(cache.Flush());
+
+    BOOST_CHECK(writer.WaitForWrite());
+    BOOST_CHECK(!writer.IsWriting());
+    BOOST_CHECK_EQUAL(writer.DynamicMemoryUsage(), 0U);
+    BOOST_CHECK(db.GetBestBlock() == block2);
+    for (size_t i = 0; i < outpoints.size(); ++i) {
+        BOOST_CHECK_EQUAL(db.HaveCoin(outpoints[i]), i % 2 == 1);
+    }
 }
 
 // Store of all necessary tx and undo data for next test
@@ -613,8 +655,7 @@ void GetCoinsMapEntry(const CCoinsMap& map, CAmount& value, char& flags, const C
 
 void WriteCoinsViewEntry(CCoinsView& view, CAmount value, char flags)
 {
-    CCoinsMapMemoryResource resource;
-    CCoinsMap map{0, CCoinsMap::hasher{}, CCoinsMap::key_equal{}, &resource};
+    CCoinsMap map{CCoinsMap::hasher{}};
     InsertCoinsMapEntry(map, value, flags);
     BOOST_CHECK(view.BatchWrite(map, {}));
 }
@@ -1084,29 +1125,69 @@ BOOST_AUTO_TEST_CASE(ccoins_flush_behavior)
     }
 }
 
-BOOST_AUTO_TEST_CASE(coins_resource_is_used)
+BOOST_AUTO_TEST_CASE(ccoins_warm)
 {
-    CCoinsMapMemoryResource resource;
-    PoolResourceTester::CheckAllDataAccountedFor(resource);
-
+    CCoinsViewDB base{{.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {}};
+    const COutPoint outp{InsecureRand256(), 0};
+    const Coin coin{CTxOut{InsecureRandMoneyAmount(), CScript{} << InsecureRand32()}, 1, false};
     {
-        CCoinsMap map{0, CCoinsMap::hasher{}, CCoinsMap::key_equal{}, &resource};
-        BOOST_TEST(memusage::DynamicUsage(map) >= resource.ChunkSizeBytes());
+        CCoinsViewCacheTest cache{&base};
+        cache.AddCoin(outp, Coin{coin}, /*possible_overwrite=*/false);
+        cache.SetBestBlock(InsecureRand256());
+        cache.Flush();
+    }
 
-        map.reserve(1000);
+    CCoinsViewCacheTest cache{&base};
+    const size_t usage{cache.DynamicMemoryUsage()};
+    BOOST_CHECK(cache.WarmCoin(outp, Coin{coin}));
+    BOOST_CHECK(cache.DynamicMemoryUsage() > usage);
+    BOOST_CHECK(!cache.WarmCoin(outp, Coin{coin}));
 
-        // The resource has preallocated a chunk, so we should have space for at several nodes without the need to allocate anything else.
-        const auto usage_before = memusage::DynamicUsage(map);
+    // A warmed coin is served from the cache, without reading the base.
+    CAmount value;
+    char flags;
+    GetCoinsMapEntry(cache.map(), value, flags, outp);
+    BOOST_CHECK_EQUAL(value, coin.out.nValue);
+    BOOST_CHECK_EQUAL(flags, 0);
+    BOOST_CHECK(cache.AccessCoin(outp) == coin);
+    BOOST_CHECK_EQUAL(cache.GetBaseReads(), 0U);
+
+    BOOST_CHECK(cache.AccessCoin(COutPoint{outp.hash, 1}).IsSpent());
+    BOOST_CHECK_EQUAL(cache.GetBaseReads(), 0U);
+    cache.SpendCoin(outp);
+    cache.SetBestBlock(InsecureRand256());
+    BOOST_CHECK_EQUAL(cache.GetBaseWrites(), 0U);
+    cache.Flush();
+    BOOST_CHECK_EQUAL(cache.GetBaseWrites(), 1U);
+    BOOST_CHECK(!base.HaveCoin(outp));
 
-        COutPoint out_point{};
-        for (size_t i = 0; i < 1000; ++i) {
-            out_point.n = i;
-            map[out_point];
-        }
-        BOOST_TEST(usage_before == memusage::DynamicUsage(map));
+    BOOST_CHECK(!cache.HaveCoin(outp));
+    BOOST_CHECK_EQUAL(cache.GetBaseReads(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(coins_map_memory_usage)
+{
+    CCoinsMap map{CCoinsMap::hasher{}};
+    BOOST_CHECK_EQUAL(memusage::DynamicUsage(map), 0U);
+
+    map.reserve(1000);
+    const size_t slots{map.SlotCount()};
+    BOOST_CHECK(slots * 7 >= 1000 * 8);
+
+    // Having reserved, the slot table is not regrown, only chunks of entries
+    // are added, and every entry is accounted for.
+    COutPoint out_point{};
+    for (size_t i = 0; i < 1000; ++i) {
+        out_point.n = i;
+        map[out_point];
     }
+    BOOST_CHECK_EQUAL(map.SlotCount(), slots);
+    BOOST_CHECK(memusage::DynamicUsage(map) >= memusage::MallocUsage(sizeof(uint64_t) * slots) + 1000 * sizeof(CCoinsMap::value_type));
 
-    PoolResourceTester::CheckAllDataAccountedFor(resource);
+    // Clearing keeps the memory allocated.
+    const size_t usage{memusage::DynamicUsage(map)};
+    map.clear();
+    BOOST_CHECK_EQUAL(memusage::DynamicUsage(map), usage);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
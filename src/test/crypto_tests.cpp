@@ -14,6 +14,7 @@
 #include <crypto/sha256.h>
 #include <crypto/sha3.h>
 #include <crypto/sha512.h>
+#include <crypto/yespower.h>
 #include <crypto/muhash.h>
 #include <random.h>
 #include <streams.h>
@@ -1292,4 +1293,44 @@ BOOST_AUTO_TEST_CASE(muhash_tests)
     BOOST_CHECK_EQUAL(HexStr(out4), "3a31e6903aff0de9f62f9a9f7f8b861de76ce2cda09822b90014319ae5dc2271");
 }
 
+static void TestYespower(uint32_t N, const char* pers, const std::string& hexout)
+{
+    const yespower_params_t params{YESPOWER_1_0, N, 32, (const uint8_t*)pers, pers ? strlen(pers) : 0};
+    uint8_t src[80];
+    for (size_t i = 0; i < sizeof(src); ++i) src[i] = i * 3;
+
+    yespower_binary_t out;
+    BOOST_CHECK_EQUAL(yespower_tls(src, sizeof(src), &params, &out), 0);
+    BOOST_CHECK_EQUAL(HexStr(out.uc), hexout);
+
+    yespower_local_t local;
+    BOOST_CHECK_EQUAL(yespower_init_local(&local), 0);
+    BOOST_CHECK_EQUAL(yespower(&local, src, sizeof(src), &params, &out), 0);
+    BOOST_CHECK_EQUAL(HexStr(out.uc), hexout);
+    BOOST_CHECK_EQUAL(yespower_free_local(&local), 0);
+}
+
+BOOST_AUTO_TEST_CASE(yespower_implementations)
+{
+    // Test vectors from crypto/yespower-1.0.1/TESTS-OK, checked against every
+    // implementation this CPU supports.
+    for (const auto use_implementation : {yespower_implementation::STANDARD, yespower_implementation::USE_AVX2, yespower_implementation::USE_AVX512}) {
+        BOOST_TEST_MESSAGE("Using the '" << YespowerAutoDetect(use_implementation) << "' yespower implementation");
+        TestYespower(2048, nullptr, "d5efb813cd263e9b34540130233cbbc6a921fbff3431e5ec1a1abde2aea6ff4d");
+        TestYespower(1024, "personality test", "1f0269acf565c49adc0ef9b8f26ab3808cdc38394a254fddeedcc3aacff6ad9d");
+    }
+    YespowerAutoDetect();
+}
+
+BOOST_AUTO_TEST_CASE(yespower_hugepages)
+{
+    // The local region is allocated on the first hash, with huge pages if the
+    // system has any and regular pages otherwise. Either way the result is
+    // the same.
+    YespowerUseHugePages(true);
+    TestYespower(2048, nullptr, "d5efb813cd263e9b34540130233cbbc6a921fbff3431e5ec1a1abde2aea6ff4d");
+    TestYespower(1024, "personality test", "1f0269acf565c49adc0ef9b8f26ab3808cdc38394a254fddeedcc3aacff6ad9d");
+    YespowerUseHugePages(false);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
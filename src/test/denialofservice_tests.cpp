@@ -7,12 +7,17 @@
 #include <banman.h>
 #include <chainparams.h>
 #include <common/args.h>
+#include <consensus/merkle.h>
 #include <net.h>
 #include <net_processing.h>
+#include <netmessagemaker.h>
+#include <node/miner.h>
+#include <primitives/block.h>
 #include <pubkey.h>
 #include <script/sign.h>
 #include <script/signingprovider.h>
 #include <serialize.h>
+#include <test/util/mining.h>
 #include <test/util/net.h>
 #include <test/util/random.h>
 #include <test/util/setup_common.h>
@@ -20,8 +25,10 @@
 #include <util/string.h>
 #include <util/time.h>
 #include <validation.h>
+#include <validationinterface.h>
 
 #include <array>
+#include <functional>
 #include <stdint.h>
 
 #include <boost/test/unit_test.hpp>
@@ -436,4 +443,90 @@ BOOST_AUTO_TEST_CASE(DoS_bantime)
     peerLogic->FinalizeNode(dummyNode);
 }
 
+// Test that blocks are processed the same when they are prevalidated on the
+// BlockPrevalidator threads: a valid block is accepted, and the peer that
+// sends an invalid one is punished.
+BOOST_FIXTURE_TEST_CASE(block_prevalidation, RegTestingSetup)
+{
+    LOCK(NetEventsInterface::g_msgproc_mutex);
+
+    auto banman = std::make_unique<BanMan>(m_args.GetDataDirBase() / "banlist", nullptr, DEFAULT_MISBEHAVING_BANTIME);
+    auto connman = std::make_unique<ConnmanTestMsg>(0x1337, 0x1337, *m_node.addrman, *m_node.netgroupman, Params());
+    PeerManager::Options peerman_opts;
+    peerman_opts.block_prevalidation_threads = 2;
+    auto peerLogic = PeerManager::make(*connman, *m_node.addrman, banman.get(), *m_node.chainman, *m_node.mempool, peerman_opts);
+    CConnman::Options options;
+    options.m_msgproc = peerLogic.get();
+    connman->Init(options);
+    // Punishment for invalid blocks is handled in BlockChecked().
+    RegisterValidationInterface(peerLogic.get());
+    banman->ClearBanned();
+
+    CAddress addr(ip(0xa0b0c001), NODE_NONE);
+    CNode* dummyNode = new CNode{/*id=*/0,
+                                  /*sock=*/nullptr,
+                                  addr,
+                                  /*nKeyedNetGroupIn=*/0,
+                                  /*nLocalHostNonceIn=*/0,
+                                  CAddress(),
+                                  /*addrNameIn=*/"",
+                                  ConnectionType::OUTBOUND_FULL_RELAY,
+                                  /*inbound_onion=*/false};
+    connman->Handshake(
+        /*node=*/*dummyNode,
+        /*successfully_connected=*/true,
+        /*remote_services=*/ServiceFlags(NODE_NETWORK | NODE_WITNESS),
+        /*local_services=*/ServiceFlags(NODE_NETWORK | NODE_WITNESS),
+        /*version=*/PROTOCOL_VERSION,
+        /*relay_txs=*/true);
+    connman->AddTestNode(*dummyNode);
+
+    const auto create_block{[&] {
+        return node::BlockAssembler{m_node.chainman->ActiveChainstate(), nullptr}.CreateNewBlock(CScript() << OP_TRUE)->block;
+    }};
+    const auto mine{[&](CBlock& block) {
+        block.hashMerkleRoot = BlockMerkleRoot(block);
+        MemoizeValidPoW(block);
+    }};
+    // Send the block, and give the prevalidator threads time to pick it up
+    // until done() holds.
+    const auto send_block{[&](const CBlock& block, const std::function<bool()>& done) {
+        connman->FlushSendBuffer(*dummyNode);
+        (void)connman->ReceiveMsgFrom(*dummyNode, CNetMsgMaker{PROTOCOL_VERSION}.Make(NetMsgType::BLOCK, block));
+        for (int i = 0; i < 1000 && !done(); ++i) {
+            dummyNode->fPauseSend = false;
+            connman->ProcessMessagesOnce(*dummyNode);
+            UninterruptibleSleep(10ms);
+        }
+    }};
+    const auto tip_hash{[&] { return WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Tip()->GetBlockHash()); }};
+
+    CBlock valid_block{create_block()};
+    mine(valid_block);
+    send_block(valid_block, [&] { return tip_hash() == valid_block.GetHash(); });
+    BOOST_CHECK(tip_hash() == valid_block.GetHash());
+    BOOST_CHECK(!dummyNode->fDisconnect);
+
+    // The coinbase pays more than the block reward, which only ConnectBlock()
+    // detects, after the block passed prevalidation.
+    CBlock invalid_block{create_block()};
+    CMutableTransaction coinbase{*invalid_block.vtx[0]};
+    coinbase.vout[0].nValue += 1;
+    invalid_block.vtx[0] = MakeTransactionRef(coinbase);
+    mine(invalid_block);
+    send_block(invalid_block, [&] {
+        LOCK(cs_main);
+        const CBlockIndex* pindex{m_node.chainman->m_blockman.LookupBlockIndex(invalid_block.GetHash())};
+        return pindex && (pindex->nStatus & BLOCK_FAILED_MASK);
+    });
+    BOOST_CHECK(tip_hash() == valid_block.GetHash());
+    BOOST_CHECK(peerLogic->SendMessages(dummyNode));
+    BOOST_CHECK(dummyNode->fDisconnect);
+    BOOST_CHECK(banman->IsDiscouraged(addr));
+
+    UnregisterValidationInterface(peerLogic.get());
+    peerLogic->FinalizeNode(*dummyNode);
+    connman->ClearTestNodes();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
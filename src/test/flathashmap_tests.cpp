@@ -0,0 +1,146 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <flathashmap.h>
+#include <memusage.h>
+#include <test/util/random.h>
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+
+BOOST_FIXTURE_TEST_SUITE(flathashmap_tests, BasicTestingSetup)
+
+namespace {
+//! A deliberately weak hash, so that probe sequences collide a lot.
+struct WeakHash {
+    uint64_t operator()(uint32_t key) const { return (uint64_t{key} << 32) | (key % 64); }
+};
+
+using Map = FlatHashMap<uint32_t, uint64_t, WeakHash>;
+
+void CheckEqual(const Map& map, const std::map<uint32_t, uint64_t>& expected)
+{
+    BOOST_REQUIRE_EQUAL(map.size(), expected.size());
+    size_t iterated{0};
+    for (const auto& [key, value] : map) {
+        const auto it{expected.find(key)};
+        BOOST_REQUIRE(it != expected.end());
+        BOOST_CHECK_EQUAL(value, it->second);
+        ++iterated;
+    }
+    BOOST_CHECK_EQUAL(iterated, expected.size());
+    for (const auto& [key, value] : expected) {
+        const auto it{map.find(key)};
+        BOOST_REQUIRE(it != map.end());
+        BOOST_CHECK_EQUAL(it->second, value);
+    }
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(flathashmap_random)
+{
+    Map map;
+    std::map<uint32_t, uint64_t> expected;
+    for (int round = 0; round < 20000; ++round) {
+        const uint32_t key = InsecureRandRange(2000);
+        switch (InsecureRandRange(4)) {
+        case 0:
+        case 1: {
+            const uint64_t value{InsecureRand32()};
+            const auto [it, inserted] = map.try_emplace(key, value);
+            BOOST_CHECK_EQUAL(inserted, expected.emplace(key, value).second);
+            BOOST_CHECK_EQUAL(it->first, key);
+            BOOST_CHECK_EQUAL(it->second, expected.at(key));
+            break;
+        }
+        case 2:
+            BOOST_CHECK_EQUAL(map.erase(key), expected.erase(key));
+            break;
+        case 3:
+            BOOST_CHECK_EQUAL(map.count(key), expected.count(key));
+            map[key] += 1;
+            expected[key] += 1;
+            break;
+        }
+        if (round % 1000 == 0) CheckEqual(map, expected);
+    }
+    CheckEqual(map, expected);
+
+    map.clear();
+    expected.clear();
+    CheckEqual(map, expected);
+    BOOST_CHECK(map.find(0) == map.end());
+}
+
+BOOST_AUTO_TEST_CASE(flathashmap_erase_while_iterating)
+{
+    Map map;
+    std::map<uint32_t, uint64_t> expected;
+    for (uint32_t key = 0; key < 5000; ++key) {
+        map.emplace(key, key);
+        expected.emplace(key, key);
+    }
+    // Every entry is visited exactly once, also the ones moved into the
+    // place of erased entries.
+    std::map<uint32_t, int> visits;
+    for (auto it = map.begin(); it != map.end();) {
+        ++visits[it->first];
+        if (it->first % 3 == 0) {
+            expected.erase(it->first);
+            it = map.erase(it);
+        } else {
+            it = std::next(it);
+        }
+    }
+    BOOST_CHECK_EQUAL(visits.size(), 5000U);
+    for (const auto& [key, count] : visits) BOOST_CHECK_EQUAL(count, 1);
+    CheckEqual(map, expected);
+
+    // Erasing everything leaves the map empty, and keeps the slots of erased
+    // entries from filling up the table.
+    const size_t slots{map.SlotCount()};
+    for (auto it = map.begin(); it != map.end();) it = map.erase(it);
+    BOOST_CHECK(map.empty());
+    for (uint32_t key = 0; key < 100000; ++key) {
+        map.emplace(key % 1000, key);
+        map.erase(key % 1000);
+    }
+    BOOST_CHECK(map.empty());
+    BOOST_CHECK_EQUAL(map.SlotCount(), slots);
+}
+
+BOOST_AUTO_TEST_CASE(flathashmap_move_only_and_move)
+{
+    FlatHashMap<uint32_t, std::unique_ptr<uint32_t>, WeakHash> map;
+    for (uint32_t key = 0; key < 1000; ++key) {
+        map.emplace(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::make_unique<uint32_t>(key)));
+    }
+    for (uint32_t key = 0; key < 1000; key += 2) BOOST_CHECK_EQUAL(map.erase(key), 1U);
+
+    const size_t usage{memusage::DynamicUsage(map)};
+    auto moved{std::move(map)};
+    BOOST_CHECK(map.empty());
+    BOOST_CHECK_EQUAL(memusage::DynamicUsage(map), 0U);
+    BOOST_CHECK_EQUAL(memusage::DynamicUsage(moved), usage);
+    BOOST_CHECK_EQUAL(moved.size(), 500U);
+    for (uint32_t key = 0; key < 1000; ++key) {
+        const auto it{moved.find(key)};
+        if (key % 2) {
+            BOOST_REQUIRE(it != moved.end());
+            BOOST_CHECK_EQUAL(*it->second, key);
+        } else {
+            BOOST_CHECK(it == moved.end());
+        }
+    }
+
+    map = std::move(moved);
+    BOOST_CHECK_EQUAL(map.size(), 500U);
+    BOOST_CHECK(moved.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
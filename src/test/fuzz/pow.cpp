@@ -13,7 +13,9 @@
 #include <util/check.h>
 #include <util/overflow.h>
 
+#include <algorithm>
 #include <cstdint>
+#include <limits>
 #include <optional>
 #include <string>
 #include <vector>
@@ -125,3 +127,49 @@ FUZZ_TARGET(pow_transition, .init = initialize_pow)
     unsigned int new_nbits{GetNextWorkRequired(last_block, nullptr, consensus_params)};
     Assert(PermittedDifficultyTransition(consensus_params, last_block->nHeight + 1, last_block->nBits, new_nbits));
 }
+
+FUZZ_TARGET(pow_lwma3_window, .init = initialize_pow)
+{
+    FuzzedDataProvider fuzzed_data_provider(buffer.data(), buffer.size());
+    Consensus::Params consensus_params{Params().GetConsensus()};
+    // A small window keeps the reference computation fast.
+    consensus_params.lwmaAveragingWindow = fuzzed_data_provider.ConsumeIntegralInRange<int64_t>(1, 64);
+    const int64_t window{consensus_params.lwmaAveragingWindow};
+    Lwma3Window lwma3_window{consensus_params};
+
+    const auto check = [&](const CBlockIndex& block) {
+        Assert(lwma3_window.NextWorkRequired(&block) == Lwma3CalculateNextWorkRequired(&block, consensus_params));
+    };
+
+    // Start from a regular chain long enough for the window to be filled, so
+    // that the fuzzed blocks get past the initial low difficulty blocks.
+    std::vector<std::unique_ptr<CBlockIndex>> blocks;
+    const int start_height{fuzzed_data_provider.ConsumeIntegralInRange<int>(window, 1100)};
+    const uint32_t start_time{fuzzed_data_provider.ConsumeIntegral<uint32_t>()};
+    const uint32_t start_bits{fuzzed_data_provider.ConsumeIntegral<uint32_t>()};
+    for (int height = 0; height <= start_height; ++height) {
+        auto block{std::make_unique<CBlockIndex>()};
+        block->pprev = blocks.empty() ? nullptr : blocks.back().get();
+        block->nHeight = height;
+        block->BuildSkip();
+        block->nTime = start_time;
+        block->nBits = start_bits;
+        blocks.push_back(std::move(block));
+    }
+    LIMITED_WHILE(fuzzed_data_provider.remaining_bytes() > 0, 2000) {
+        // Mostly extend the last block, sometimes fork off an earlier one.
+        CBlockIndex* prev{fuzzed_data_provider.ConsumeBool() ? blocks.back().get() : PickValue(fuzzed_data_provider, blocks).get()};
+        auto block{std::make_unique<CBlockIndex>()};
+        block->pprev = prev;
+        block->nHeight = prev->nHeight + 1;
+        block->BuildSkip();
+        // Timestamps may go backwards, which the algorithm has to correct for.
+        const int64_t time{int64_t{prev->nTime} + fuzzed_data_provider.ConsumeIntegralInRange<int64_t>(-7200, 7200)};
+        block->nTime = std::clamp<int64_t>(time, 0, std::numeric_limits<uint32_t>::max());
+        block->nBits = fuzzed_data_provider.ConsumeBool() ? prev->nBits : fuzzed_data_provider.ConsumeIntegral<uint32_t>();
+        check(*blocks.emplace_back(std::move(block)));
+        if (fuzzed_data_provider.ConsumeBool()) {
+            check(*PickValue(fuzzed_data_provider, blocks));
+        }
+    }
+}
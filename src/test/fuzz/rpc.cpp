@@ -125,6 +125,7 @@ const std::vector<std::string> RPC_COMMANDS_SAFE_FOR_FUZZING{
     "getchaintips",
     "getchainstates",
     "getchaintxstats",
+    "getcoinsprefetchinfo",
     "getconnectioncount",
     "getdeploymentinfo",
     "getdescriptorinfo",
@@ -141,6 +142,7 @@ const std::vector<std::string> RPC_COMMANDS_SAFE_FOR_FUZZING{
     "getnetworkinfo",
     "getnodeaddresses",
     "getpeerinfo",
+    "getpowauditinfo",
     "getprioritisedtransactions",
     "getrawaddrman",
     "getrawmempool",
@@ -92,7 +92,7 @@ BOOST_AUTO_TEST_CASE(headers_sync_state)
     // initially and then the rest.
     headers_batch.insert(headers_batch.end(), std::next(first_chain.begin()), first_chain.end());
 
-    hss.reset(new HeadersSyncState(0, Params().GetConsensus(), chain_start, chain_work));
+    hss.reset(new HeadersSyncState(0, Params().GetConsensus(), Params().HeadersSync(), chain_start, chain_work));
     (void)hss->ProcessNextHeaders({first_chain.front()}, true);
     // Pretend the first header is still "full", so we don't abort.
     auto result = hss->ProcessNextHeaders(headers_batch, true);
@@ -109,7 +109,7 @@ BOOST_AUTO_TEST_CASE(headers_sync_state)
     BOOST_CHECK(hss->GetState() == HeadersSyncState::State::FINAL);
 
     // Now try again, this time feeding the first chain twice.
-    hss.reset(new HeadersSyncState(0, Params().GetConsensus(), chain_start, chain_work));
+    hss.reset(new HeadersSyncState(0, Params().GetConsensus(), Params().HeadersSync(), chain_start, chain_work));
     (void)hss->ProcessNextHeaders(first_chain, true);
     BOOST_CHECK(hss->GetState() == HeadersSyncState::State::REDOWNLOAD);
 
@@ -123,7 +123,7 @@ BOOST_AUTO_TEST_CASE(headers_sync_state)
 
     // Finally, verify that just trying to process the second chain would not
     // succeed (too little work)
-    hss.reset(new HeadersSyncState(0, Params().GetConsensus(), chain_start, chain_work));
+    hss.reset(new HeadersSyncState(0, Params().GetConsensus(), Params().HeadersSync(), chain_start, chain_work));
     BOOST_CHECK(hss->GetState() == HeadersSyncState::State::PRESYNC);
      // Pretend just the first message is "full", so we don't abort.
     (void)hss->ProcessNextHeaders({second_chain.front()}, true);
@@ -143,4 +143,56 @@ BOOST_AUTO_TEST_CASE(headers_sync_state)
     BOOST_CHECK(result.success);
 }
 
+// Headers whose proof of work was checked during PRESYNC are recognized when
+// they are redownloaded, up to the last one whose hash was stored, as long as
+// they continue the redownloaded chain.
+BOOST_AUTO_TEST_CASE(headers_sync_presync_pow_checked)
+{
+    std::vector<CBlockHeader> first_chain;
+    std::vector<CBlockHeader> second_chain;
+    GenerateHeaders(first_chain, 100, Params().GenesisBlock().GetHash(),
+            Params().GenesisBlock().nVersion, Params().GenesisBlock().nTime,
+            ArithToUint256(0), Params().GenesisBlock().nBits);
+    GenerateHeaders(second_chain, 100, Params().GenesisBlock().GetHash(),
+            Params().GenesisBlock().nVersion, Params().GenesisBlock().nTime,
+            ArithToUint256(1), Params().GenesisBlock().nBits);
+
+    const CBlockIndex* chain_start = WITH_LOCK(::cs_main, return m_node.chainman->m_blockman.LookupBlockIndex(Params().GenesisBlock().GetHash()));
+    HeadersSyncState hss{0, Params().GetConsensus(), Params().HeadersSync(), chain_start, /*minimum_required_work=*/GetBlockProof(*chain_start) * 50};
+
+    // Nothing is recognized before the chain has been presynced.
+    BOOST_CHECK_EQUAL(hss.CountPresyncCheckedHeaders(first_chain), 0U);
+    (void)hss.ProcessNextHeaders(first_chain, true);
+    BOOST_REQUIRE(hss.GetState() == HeadersSyncState::State::REDOWNLOAD);
+
+    // The hash of the header at height 64 is stored, which vouches for the
+    // headers before it, but not for the ones after it.
+    BOOST_CHECK_EQUAL(hss.CountPresyncCheckedHeaders(first_chain), 64U);
+    BOOST_CHECK_EQUAL(hss.CountPresyncCheckedHeaders(second_chain), 0U);
+    // A header with a different nonce is not the one that was checked.
+    std::vector<CBlockHeader> modified_chain{first_chain};
+    ++modified_chain[63].nNonce;
+    BOOST_CHECK_EQUAL(hss.CountPresyncCheckedHeaders(modified_chain), 0U);
+    modified_chain = first_chain;
+    ++modified_chain[70].nNonce;
+    BOOST_CHECK_EQUAL(hss.CountPresyncCheckedHeaders(modified_chain), 64U);
+
+    // Headers are matched by height, from where the redownload continues.
+    const std::vector<CBlockHeader> first_part(first_chain.begin(), first_chain.begin() + 30);
+    const std::vector<CBlockHeader> second_part(first_chain.begin() + 30, first_chain.end());
+    BOOST_CHECK_EQUAL(hss.CountPresyncCheckedHeaders(second_part), 0U);
+    auto result{hss.ProcessNextHeaders(first_part, true)};
+    BOOST_REQUIRE(hss.GetState() == HeadersSyncState::State::REDOWNLOAD);
+    BOOST_CHECK(result.pow_validated_headers.empty());
+    BOOST_CHECK_EQUAL(hss.CountPresyncCheckedHeaders(second_part), 34U);
+    BOOST_CHECK_EQUAL(hss.CountPresyncCheckedHeaders(first_part), 0U);
+
+    // Once the redownloaded chain has enough work, all headers are returned,
+    // and the ones up to height 64 were checked during PRESYNC.
+    result = hss.ProcessNextHeaders(second_part, true);
+    BOOST_CHECK(result.success);
+    BOOST_CHECK_EQUAL(result.pow_validated_headers.size(), first_chain.size());
+    BOOST_CHECK_EQUAL(result.presync_pow_checked, 64U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -3,14 +3,19 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <addresstype.h>
+#include <arith_uint256.h>
+#include <chainparams.h>
 #include <coins.h>
 #include <common/system.h>
 #include <consensus/consensus.h>
 #include <consensus/merkle.h>
 #include <consensus/tx_verify.h>
+#include <node/blocktemplatecache.h>
 #include <node/miner.h>
 #include <policy/policy.h>
+#include <pow.h>
 #include <test/util/random.h>
+#include <test/util/script.h>
 #include <test/util/txmempool.h>
 #include <timedata.h>
 #include <txmempool.h>
@@ -18,16 +23,22 @@
 #include <util/strencodings.h>
 #include <util/time.h>
 #include <validation.h>
+#include <validationinterface.h>
 #include <versionbits.h>
 
 #include <test/util/setup_common.h>
 
+#include <limits>
+#include <chrono>
 #include <memory>
 
 #include <boost/test/unit_test.hpp>
 
 using node::BlockAssembler;
+using node::BlockTemplateCache;
+using node::BlockTemplateSnapshot;
 using node::CBlockTemplate;
+using node::SolveBlockNonce;
 
 namespace miner_tests {
 struct MinerTestingSetup : public TestingSetup {
@@ -51,6 +62,20 @@ struct MinerTestingSetup : public TestingSetup {
         return *m_node.mempool;
     }
     BlockAssembler AssemblerForTest(CTxMemPool& tx_mempool);
+    /**
+     * Submit a transaction to the mempool spending prevout, which pays value
+     * to P2WSH_OP_TRUE, to another such output, leaving fee.
+     */
+    CTransactionRef SubmitSpend(const COutPoint& prevout, CAmount value, CAmount fee) EXCLUSIVE_LOCKS_REQUIRED(::cs_main)
+    {
+        CMutableTransaction mtx;
+        mtx.vin.emplace_back(prevout);
+        mtx.vin[0].scriptWitness.stack.push_back(WITNESS_STACK_ELEM_OP_TRUE);
+        mtx.vout.emplace_back(value - fee, P2WSH_OP_TRUE);
+        const CTransactionRef tx{MakeTransactionRef(std::move(mtx))};
+        BOOST_CHECK(m_node.chainman->ProcessTransaction(tx).m_result_type == MempoolAcceptResult::ResultType::VALID);
+        return tx;
+    }
 };
 } // namespace miner_tests
 
@@ -655,4 +680,176 @@ BOOST_AUTO_TEST_CASE(CreateNewBlock_validity)
     TestPrioritisedMining(scriptPubKey, txFirst);
 }
 
+BOOST_AUTO_TEST_CASE(block_template_cache)
+{
+    CTxMemPool& tx_mempool{*m_node.mempool};
+    BlockTemplateCache cache{*m_node.chainman, tx_mempool, BlockAssembler::Options{}};
+    RegisterValidationInterface(&cache);
+
+    std::shared_ptr<const BlockTemplateSnapshot> first;
+    {
+        LOCK(cs_main);
+        first = cache.GetTemplate();
+        BOOST_CHECK(first->prev == m_node.chainman->ActiveChain().Tip());
+        BOOST_CHECK_EQUAL(first->tmpl.block.vtx.size(), 1U);
+        // Nothing changed, so the same template is served.
+        BOOST_CHECK(cache.GetTemplate() == first);
+    }
+
+    // Transactions entering the mempool are appended to the template, all of
+    // them at once.
+    const COutPoint prevout{InsecureRand256(), 0};
+    const CAmount value{1 * COIN};
+    CTransactionRef tx, child;
+    {
+        LOCK(cs_main);
+        m_node.chainman->ActiveChainstate().CoinsTip().AddCoin(prevout, Coin{CTxOut{value, P2WSH_OP_TRUE}, 0, false}, /*possible_overwrite=*/false);
+        tx = SubmitSpend(prevout, value, /*fee=*/10000);
+        child = SubmitSpend(COutPoint{tx->GetHash(), 0}, value - 10000, /*fee=*/10000);
+    }
+    SyncWithValidationInterfaceQueue();
+    {
+        LOCK(cs_main);
+        const auto second{cache.GetTemplate()};
+        BOOST_CHECK_EQUAL(second->id, first->id + 1);
+        BOOST_CHECK(second->prev == first->prev);
+        BOOST_REQUIRE_EQUAL(second->tmpl.block.vtx.size(), 3U);
+        BOOST_CHECK(second->tmpl.block.vtx[1] == tx);
+        BOOST_CHECK(second->tmpl.block.vtx[2] == child);
+        BOOST_CHECK_EQUAL(second->tmpl.vTxFees[1], 10000);
+        BOOST_CHECK_EQUAL(second->tmpl.vTxFees[2], 10000);
+        BOOST_CHECK_EQUAL(second->tmpl.vTxFees[0], -20000);
+        BOOST_CHECK_EQUAL(second->tmpl.block.vtx[0]->GetValueOut(), first->tmpl.block.vtx[0]->GetValueOut() + 20000);
+        BOOST_CHECK(second->tmpl.block.hashMerkleRoot == BlockMerkleRoot(second->tmpl.block));
+        BlockValidationState state;
+        BOOST_CHECK(TestBlockValidity(state, Params(), m_node.chainman->ActiveChainstate(), second->tmpl.block, m_node.chainman->ActiveChain().Tip(),
+                                      GetAdjustedTime, /*fCheckPOW=*/false, /*fCheckMerkleRoot=*/true));
+        // A published template is never modified.
+        BOOST_CHECK_EQUAL(first->tmpl.block.vtx.size(), 1U);
+    }
+
+    // Losing it for any reason other than being mined makes the template stale.
+    {
+        LOCK2(cs_main, tx_mempool.cs);
+        tx_mempool.removeRecursive(*tx, MemPoolRemovalReason::REPLACED);
+    }
+    SyncWithValidationInterfaceQueue();
+    {
+        LOCK(cs_main);
+        BOOST_CHECK_EQUAL(cache.GetTemplate()->tmpl.block.vtx.size(), 1U);
+    }
+
+    UnregisterValidationInterface(&cache);
+}
+
+BOOST_AUTO_TEST_CASE(block_template_cache_longpoll)
+{
+    CTxMemPool& tx_mempool{*m_node.mempool};
+    BlockTemplateCache cache{*m_node.chainman, tx_mempool, BlockAssembler::Options{}};
+    RegisterValidationInterface(&cache);
+
+    std::vector<std::shared_ptr<const BlockTemplateSnapshot>> woken;
+    const auto wait{[&](const uint256& prev_hash, unsigned int transactions_updated, std::chrono::steady_clock::time_point check_txs_time) {
+        LOCK(cs_main);
+        cache.AddWaiter(prev_hash, transactions_updated, check_txs_time,
+                        [&woken](std::shared_ptr<const BlockTemplateSnapshot> snapshot) { woken.push_back(std::move(snapshot)); });
+    }};
+    const auto later{std::chrono::steady_clock::now() + std::chrono::hours{1}};
+
+    std::shared_ptr<const BlockTemplateSnapshot> first;
+    WITH_LOCK(cs_main, first = cache.GetTemplate());
+    const uint256 tip_hash{first->prev->GetBlockHash()};
+    std::vector<std::shared_ptr<const BlockTemplateSnapshot>> published;
+    cache.AddListener([&published](const std::shared_ptr<const BlockTemplateSnapshot>& snapshot) { published.push_back(snapshot); });
+
+    // A longpoll for another block gets the current template right away.
+    wait(uint256::ONE, first->transactions_updated, later);
+    BOOST_REQUIRE_EQUAL(woken.size(), 1U);
+    BOOST_CHECK(woken[0] == first);
+
+    // Longpolls for the current template wait, and all of them get the same
+    // template once the mempool changed after their deadline.
+    wait(tip_hash, first->transactions_updated, later);
+    wait(tip_hash, first->transactions_updated, std::chrono::steady_clock::now());
+    wait(tip_hash, first->transactions_updated, std::chrono::steady_clock::now());
+    BOOST_CHECK_EQUAL(woken.size(), 1U);
+
+    const COutPoint prevout{InsecureRand256(), 0};
+    CTransactionRef tx;
+    {
+        LOCK(cs_main);
+        m_node.chainman->ActiveChainstate().CoinsTip().AddCoin(prevout, Coin{CTxOut{1 * COIN, P2WSH_OP_TRUE}, 0, false}, /*possible_overwrite=*/false);
+        tx = SubmitSpend(prevout, 1 * COIN, /*fee=*/10000);
+    }
+    SyncWithValidationInterfaceQueue();
+    // Without the background thread, the transaction is appended once the
+    // template is requested.
+    WITH_LOCK(cs_main, cache.GetTemplate());
+    BOOST_REQUIRE_EQUAL(woken.size(), 3U);
+    BOOST_CHECK(woken[1] != first);
+    BOOST_CHECK(woken[1] == woken[2]);
+    BOOST_CHECK_EQUAL(woken[1]->tmpl.block.vtx.size(), 2U);
+    // Listeners get every new template once.
+    BOOST_REQUIRE_EQUAL(published.size(), 1U);
+    BOOST_CHECK(published[0] == woken[1]);
+
+    // On shutdown, waiting and new longpolls are called back without a template.
+    cache.Interrupt();
+    BOOST_REQUIRE_EQUAL(woken.size(), 4U);
+    BOOST_CHECK(!woken[3]);
+    wait(tip_hash, woken[1]->transactions_updated, later);
+    BOOST_REQUIRE_EQUAL(woken.size(), 5U);
+    BOOST_CHECK(!woken[4]);
+
+    UnregisterValidationInterface(&cache);
+    WITH_LOCK(tx_mempool.cs, tx_mempool.removeRecursive(*tx, MemPoolRemovalReason::REPLACED));
+}
+
+BOOST_FIXTURE_TEST_CASE(SolveBlockNonce_threads, BasicTestingSetup)
+{
+    // An easy target, so a solution is found within a few dozen nonces.
+    Consensus::Params params{Params().GetConsensus()};
+    params.powLimit = uint256S("0fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+    CBlockHeader header;
+    header.nVersion = VERSIONBITS_TOP_BITS;
+    header.hashMerkleRoot = InsecureRand256();
+    header.nBits = UintToArith256(params.powLimit).GetCompact();
+    const auto not_interrupted{[] { return false; }};
+
+    CBlockHeader solved{header};
+    uint64_t max_tries{1000};
+    BOOST_REQUIRE(SolveBlockNonce(solved, params, max_tries, /*threads=*/1, not_interrupted));
+    BOOST_CHECK(CheckProofOfWork(solved.GetPoWHash(), solved.nBits, params));
+    BOOST_CHECK_EQUAL(max_tries, 1000 - solved.nNonce);
+
+    // More threads find the same, lowest, nonce.
+    for (const int threads : {2, 4}) {
+        CBlockHeader block{header};
+        max_tries = 1000;
+        BOOST_CHECK(SolveBlockNonce(block, params, max_tries, threads, not_interrupted));
+        BOOST_CHECK_EQUAL(block.nNonce, solved.nNonce);
+        BOOST_CHECK_EQUAL(max_tries, 1000 - solved.nNonce);
+    }
+
+    // Running out of tries just before the solution.
+    CBlockHeader block{header};
+    max_tries = solved.nNonce;
+    BOOST_CHECK(!SolveBlockNonce(block, params, max_tries, /*threads=*/4, not_interrupted));
+    BOOST_CHECK_EQUAL(block.nNonce, solved.nNonce);
+    BOOST_CHECK_EQUAL(max_tries, 0U);
+
+    // The maximum nonce is never tried.
+    block.nNonce = std::numeric_limits<uint32_t>::max();
+    max_tries = 1000;
+    BOOST_CHECK(!SolveBlockNonce(block, params, max_tries, /*threads=*/4, not_interrupted));
+    BOOST_CHECK_EQUAL(block.nNonce, std::numeric_limits<uint32_t>::max());
+    BOOST_CHECK_EQUAL(max_tries, 1000U);
+
+    // An interrupted search gives up.
+    block = header;
+    max_tries = 1000;
+    BOOST_CHECK(!SolveBlockNonce(block, params, max_tries, /*threads=*/4, [] { return true; }));
+    BOOST_CHECK_EQUAL(max_tries, 1000U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
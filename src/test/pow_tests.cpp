@@ -4,13 +4,22 @@
 
 #include <chain.h>
 #include <chainparams.h>
+#include <crypto/common.h>
+#include <hash.h>
 #include <pow.h>
+#include <primitives/block.h>
+#include <streams.h>
 #include <test/util/random.h>
 #include <test/util/setup_common.h>
 #include <util/chaintype.h>
+#include <version.h>
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
 BOOST_FIXTURE_TEST_SUITE(pow_tests, BasicTestingSetup)
 
 /* Test calculation of next difficulty target with no constraints applying */
@@ -160,6 +169,37 @@ BOOST_AUTO_TEST_CASE(GetBlockProofEquivalentTime_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(lwma3_window_matches_reference)
+{
+    const auto chainParams = CreateChainParams(*m_node.args, ChainType::MAIN);
+    const Consensus::Params& consensus{chainParams->GetConsensus()};
+    std::vector<CBlockIndex> blocks(2000);
+    for (int i = 0; i < 2000; i++) {
+        blocks[i].pprev = i ? &blocks[i - 1] : nullptr;
+        blocks[i].nHeight = i;
+        blocks[i].BuildSkip();
+        // Out of order timestamps every few blocks, and long and short
+        // solvetimes, exercise the solvetime corrections.
+        blocks[i].nTime = i ? blocks[i - 1].nTime + InsecureRandRange(400) - (i % 7 == 0 ? 500 : 0) : 1269211443;
+        blocks[i].nBits = 0x1e00ffff + InsecureRandRange(0xff00);
+    }
+
+    Lwma3Window window{consensus};
+    for (int i = 900; i < 2000; i++) {
+        BOOST_CHECK_EQUAL(window.NextWorkRequired(&blocks[i]), Lwma3CalculateNextWorkRequired(&blocks[i], consensus));
+    }
+    // Asking about the same tip again, an earlier one, or a fork.
+    BOOST_CHECK_EQUAL(window.NextWorkRequired(&blocks[1999]), Lwma3CalculateNextWorkRequired(&blocks[1999], consensus));
+    BOOST_CHECK_EQUAL(window.NextWorkRequired(&blocks[1500]), Lwma3CalculateNextWorkRequired(&blocks[1500], consensus));
+    CBlockIndex fork;
+    fork.pprev = &blocks[1500];
+    fork.nHeight = 1501;
+    fork.BuildSkip();
+    fork.nTime = blocks[1500].nTime - 1000;
+    fork.nBits = 0x1d00ffff;
+    BOOST_CHECK_EQUAL(window.NextWorkRequired(&fork), Lwma3CalculateNextWorkRequired(&fork, consensus));
+}
+
 void sanity_check_chainparams(const ArgsManager& args, ChainType chain_type)
 {
     const auto chainParams = CreateChainParams(args, chain_type);
@@ -207,4 +247,65 @@ BOOST_AUTO_TEST_CASE(ChainParams_SIGNET_sanity)
     sanity_check_chainparams(*m_node.args, ChainType::SIGNET);
 }
 
+BOOST_AUTO_TEST_CASE(pow_hash_memo)
+{
+    CBlockHeader header;
+    header.nVersion = 1;
+    header.hashMerkleRoot = InsecureRand256();
+    header.nBits = 0x1e0ffff0;
+    const uint256 block_hash{header.GetHash()};
+    BOOST_CHECK(!GetMemoizedPoWHash(block_hash));
+
+    const uint256 pow_hash{header.GetPoWHash_cached()};
+    BOOST_CHECK(pow_hash == header.GetPoWHash());
+    BOOST_CHECK(GetMemoizedPoWHash(block_hash) == pow_hash);
+
+    // The memo is keyed by block hash, so a changed header misses it.
+    ++header.nNonce;
+    BOOST_CHECK(!GetMemoizedPoWHash(header.GetHash()));
+    BOOST_CHECK(header.GetPoWHash_cached() == header.GetPoWHash());
+
+    // Block hashes that map to the same set evict the oldest entries once it
+    // is full, so the last four written are kept.
+    std::vector<uint256> colliding_hashes;
+    for (uint8_t i = 1; i <= 8; ++i) {
+        uint256 colliding_hash{block_hash};
+        *(colliding_hash.end() - 1) ^= i;
+        colliding_hashes.push_back(colliding_hash);
+        MemoizePoWHash(colliding_hash, uint256::ONE);
+        BOOST_CHECK(GetMemoizedPoWHash(colliding_hash) == uint256::ONE);
+    }
+    BOOST_CHECK(!GetMemoizedPoWHash(block_hash));
+    for (size_t i = 0; i < colliding_hashes.size(); ++i) {
+        BOOST_CHECK_EQUAL(GetMemoizedPoWHash(colliding_hashes[i]).has_value(), i >= 4);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(header_is_trivially_copyable)
+{
+    static_assert(std::is_trivially_copyable_v<CBlockHeader>);
+    BOOST_CHECK_EQUAL(sizeof(CBlockHeader), 80U);
+}
+
+BOOST_AUTO_TEST_CASE(header_serialize_to_array)
+{
+    CBlockHeader header;
+    header.nVersion = -2;
+    header.hashPrevBlock = InsecureRand256();
+    header.hashMerkleRoot = InsecureRand256();
+    header.nTime = InsecureRand32();
+    header.nBits = InsecureRand32();
+    header.nNonce = InsecureRand32();
+
+    const auto serialized{header.SerializeToArray()};
+    DataStream stream{};
+    stream << header;
+    BOOST_CHECK_EQUAL(stream.size(), BLOCK_HEADER_SIZE);
+    BOOST_CHECK(std::equal(serialized.begin(), serialized.end(), UCharCast(stream.data())));
+    BOOST_CHECK_EQUAL(ReadLE32(serialized.data() + BLOCK_HEADER_NONCE_OFFSET), header.nNonce);
+
+    BOOST_CHECK_EQUAL(header.GetHash(), (CHashWriter{PROTOCOL_VERSION} << header).GetHash());
+    BOOST_CHECK_EQUAL(header.GetPoWHash(), GetSerializedHeaderPoWHash(MakeUCharSpan(stream)));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,75 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <arith_uint256.h>
+#include <chain.h>
+#include <node/powaudit.h>
+#include <primitives/block.h>
+#include <test/util/setup_common.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+using node::PoWAudit;
+
+BOOST_FIXTURE_TEST_SUITE(powaudit_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(powaudit_reports_bad_entries)
+{
+    ChainstateManager& chainman{*m_node.chainman};
+    const uint256 genesis_hash{chainman.GetParams().GenesisBlock().GetHash()};
+
+    CBlockHeader header;
+    header.nVersion = 1;
+    header.hashPrevBlock = genesis_hash;
+    header.nTime = chainman.GetParams().GenesisBlock().nTime + 60;
+
+    uint256 hard_target_hash, cache_mismatch_hash;
+    {
+        LOCK(cs_main);
+        CBlockIndex* best_header{chainman.m_best_header};
+        // A yespower hash will not meet this target.
+        header.nBits = 0x1b00ffff;
+        CBlockIndex* hard_target{chainman.m_blockman.AddToBlockIndex(header, best_header)};
+        hard_target_hash = hard_target->GetBlockHash();
+
+        // A memoized hash meets any target, but is not the hash of the header.
+        header.nBits = UintToArith256(chainman.GetConsensus().powLimit).GetCompact();
+        cache_mismatch_hash = chainman.m_blockman.AddToBlockIndex(header, best_header)->GetBlockHash();
+        MemoizePoWHash(cache_mismatch_hash, uint256{});
+    }
+
+    PoWAudit audit{chainman};
+    audit.Start(/*threads=*/2);
+    for (int i = 0; i < 600 && audit.GetProgress().running; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{100});
+    }
+
+    PoWAudit::Progress progress{audit.GetProgress()};
+    BOOST_CHECK(!progress.running);
+    BOOST_CHECK_EQUAL(progress.threads, 2);
+    // The genesis block is not audited.
+    BOOST_CHECK_EQUAL(progress.total, 2U);
+    BOOST_CHECK_EQUAL(progress.checked, 2U);
+    BOOST_REQUIRE_EQUAL(progress.failed.size(), 2U);
+    BOOST_CHECK(std::count(progress.failed.begin(), progress.failed.end(), hard_target_hash) == 1);
+    BOOST_CHECK(std::count(progress.failed.begin(), progress.failed.end(), cache_mismatch_hash) == 1);
+    audit.Stop();
+}
+
+BOOST_AUTO_TEST_CASE(powaudit_stop)
+{
+    PoWAudit audit{*m_node.chainman};
+    audit.Start(/*threads=*/1);
+    audit.Stop();
+    BOOST_CHECK(!audit.GetProgress().running);
+    // Stopping twice is harmless.
+    audit.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
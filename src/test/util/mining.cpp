@@ -128,3 +128,8 @@ std::shared_ptr<CBlock> PrepareBlock(const NodeContext& node, const CScript& coi
     ApplyArgsManOptions(*node.args, assembler_options);
     return PrepareBlock(node, coinbase_scriptPubKey, assembler_options);
 }
+
+void MemoizeValidPoW(const CBlockHeader& header)
+{
+    MemoizePoWHash(header.GetHash(), uint256{});
+}
@@ -12,6 +12,7 @@
 #include <vector>
 
 class CBlock;
+class CBlockHeader;
 class CChainParams;
 class COutPoint;
 class CScript;
@@ -36,6 +37,12 @@ std::shared_ptr<CBlock> PrepareBlock(const node::NodeContext&, const CScript& co
 std::shared_ptr<CBlock> PrepareBlock(const node::NodeContext& node, const CScript& coinbase_scriptPubKey,
                                      const node::BlockAssembler::Options& assembler_options);
 
+/**
+ * Mining is out of reach for a unit test, so memoize a PoW hash for the
+ * header that meets any target instead. The header must not change after.
+ */
+void MemoizeValidPoW(const CBlockHeader& header);
+
 /** RPC-like helper function, returns the generated coin */
 COutPoint generatetoaddress(const node::NodeContext&, const std::string& address);
 
@@ -174,7 +174,7 @@ ChainTestingSetup::ChainTestingSetup(const ChainType chainType, const std::vecto
         .chainparams = chainparams,
         .datadir = m_args.GetDataDirNet(),
         .adjusted_time_callback = GetAdjustedTime,
-        .check_block_index = true,
+        .check_block_index = m_node.args->GetBoolArg("-checkblockindex", true),
         .notifications = *m_node.notifications,
     };
     const BlockManager::Options blockman_opts{
@@ -190,12 +190,16 @@ ChainTestingSetup::ChainTestingSetup(const ChainType chainType, const std::vecto
 
     constexpr int script_check_threads = 2;
     StartScriptCheckWorkerThreads(script_check_threads);
+    StartHeaderPoWCheckWorkerThreads(script_check_threads);
+    StartBlockCheckWorkerThreads(script_check_threads);
 }
 
 ChainTestingSetup::~ChainTestingSetup()
 {
     if (m_node.scheduler) m_node.scheduler->stop();
     StopScriptCheckWorkerThreads();
+    StopHeaderPoWCheckWorkerThreads();
+    StopBlockCheckWorkerThreads();
     GetMainSignals().FlushBackgroundCallbacks();
     GetMainSignals().UnregisterBackgroundSignalScheduler();
     m_node.connman.reset();
@@ -257,6 +261,9 @@ TestingSetup::TestingSetup(
     PeerManager::Options peerman_opts;
     ApplyArgsManOptions(*m_node.args, peerman_opts);
     peerman_opts.deterministic_rng = true;
+    // Process received blocks right away, so tests see their effect when
+    // ProcessMessage returns.
+    peerman_opts.block_prevalidation_threads = 0;
     m_node.peerman = PeerManager::make(*m_node.connman, *m_node.addrman,
                                        m_node.banman.get(), *m_node.chainman,
                                        *m_node.mempool, peerman_opts);
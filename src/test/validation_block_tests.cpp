@@ -5,11 +5,15 @@
 #include <boost/test/unit_test.hpp>
 
 #include <chainparams.h>
+#include <consensus/consensus.h>
 #include <consensus/merkle.h>
 #include <consensus/validation.h>
 #include <node/miner.h>
 #include <pow.h>
+#include <primitives/block.h>
 #include <random.h>
+#include <test/util/logging.h>
+#include <test/util/mining.h>
 #include <test/util/random.h>
 #include <test/util/script.h>
 #include <test/util/setup_common.h>
@@ -93,9 +97,7 @@ std::shared_ptr<CBlock> MinerTestingSetup::FinalizeBlock(std::shared_ptr<CBlock>
 
     pblock->hashMerkleRoot = BlockMerkleRoot(*pblock);
 
-    while (!CheckProofOfWork(pblock->GetHash(), pblock->nBits, Params().GetConsensus())) {
-        ++(pblock->nNonce);
-    }
+    MemoizeValidPoW(*pblock);
 
     // submit block header, so that miner can get the block height from the
     // global state and the node has the topology of the chain
@@ -358,4 +360,78 @@ BOOST_AUTO_TEST_CASE(witness_commitment_index)
 
     BOOST_CHECK_EQUAL(GetWitnessCommitmentIndex(pblock), 2);
 }
+
+BOOST_AUTO_TEST_CASE(connect_tips)
+{
+    // Blocks are connected several at a time during initial block download.
+    BOOST_REQUIRE(m_node.chainman->IsInitialBlockDownload());
+
+    // Construct a block spending the P2WSH_OP_TRUE output of the coinbase of
+    // spent_block. An invalid one also spends its own coinbase, which is only
+    // rejected once the script checks of the first spend are queued.
+    auto spending_block = [&](const uint256& prev_hash, const CBlock& spent_block, bool invalid) {
+        auto pblock = Block(prev_hash);
+        CMutableTransaction spend;
+        spend.vin.emplace_back(COutPoint(spent_block.vtx[0]->GetHash(), 1));
+        spend.vin[0].scriptWitness.stack.push_back(WITNESS_STACK_ELEM_OP_TRUE);
+        spend.vout.emplace_back(spent_block.vtx[0]->vout[1].nValue - 1000, P2WSH_OP_TRUE);
+        pblock->vtx.push_back(MakeTransactionRef(std::move(spend)));
+        if (invalid) {
+            CMutableTransaction coinbase_spend;
+            coinbase_spend.vin.emplace_back(COutPoint(pblock->vtx[0]->GetHash(), 1));
+            coinbase_spend.vin[0].scriptWitness.stack.push_back(WITNESS_STACK_ELEM_OP_TRUE);
+            coinbase_spend.vout.push_back(pblock->vtx[0]->vout[1]);
+            pblock->vtx.push_back(MakeTransactionRef(std::move(coinbase_spend)));
+        }
+        return std::shared_ptr<const CBlock>{FinalizeBlock(pblock)};
+    };
+    // Store all of the blocks before connecting any of them.
+    auto process_blocks = [&](const std::vector<std::shared_ptr<const CBlock>>& blocks) {
+        {
+            LOCK(Assert(m_node.chainman)->GetMutex());
+            for (const auto& block : blocks) {
+                BlockValidationState state;
+                BOOST_CHECK(m_node.chainman->AcceptBlock(block, state, nullptr, /*fRequested=*/true, nullptr, nullptr, /*min_pow_checked=*/true));
+            }
+        }
+        BlockValidationState state;
+        BOOST_CHECK(m_node.chainman->ActiveChainstate().ActivateBestChain(state));
+    };
+    auto tip = [&] { return WITH_LOCK(Assert(m_node.chainman)->GetMutex(), return m_node.chainman->ActiveChain().Tip()->GetBlockHash()); };
+
+    std::vector<std::shared_ptr<const CBlock>> blocks;
+    uint256 prev_hash{tip()};
+    for (int i = 0; i < COINBASE_MATURITY; ++i) {
+        blocks.push_back(GoodBlock(prev_hash));
+        prev_hash = blocks.back()->GetHash();
+    }
+    for (int i = 0; i < 8; ++i) {
+        blocks.push_back(spending_block(prev_hash, *blocks[i], /*invalid=*/false));
+        prev_hash = blocks.back()->GetHash();
+    }
+    {
+        ASSERT_DEBUG_LOG("- Connect 8 blocks");
+        process_blocks(blocks);
+    }
+    BOOST_CHECK_EQUAL(tip(), prev_hash);
+    const CoinsPrefetchStats stats{WITH_LOCK(Assert(m_node.chainman)->GetMutex(), return m_node.chainman->m_prefetch_stats)};
+    BOOST_CHECK_EQUAL(stats.inputs, 8U);
+
+    // The fifth of the next 8 blocks is invalid, so they are connected one by
+    // one up to it.
+    std::vector<std::shared_ptr<const CBlock>> more_blocks;
+    for (int i = 8; i < 16; ++i) {
+        more_blocks.push_back(spending_block(prev_hash, *blocks[i], /*invalid=*/i == 12));
+        prev_hash = more_blocks.back()->GetHash();
+    }
+    {
+        ASSERT_DEBUG_LOG("failed to connect together, connecting them one by one");
+        process_blocks(more_blocks);
+    }
+    BOOST_CHECK_EQUAL(tip(), more_blocks[3]->GetHash());
+    LOCK(Assert(m_node.chainman)->GetMutex());
+    BOOST_CHECK(m_node.chainman->m_blockman.LookupBlockIndex(more_blocks[4]->GetHash())->nStatus & BLOCK_FAILED_VALID);
+    // The blocks connected one by one are only counted once.
+    BOOST_CHECK_EQUAL(m_node.chainman->m_prefetch_stats.inputs, stats.inputs + 4);
+}
 BOOST_AUTO_TEST_SUITE_END()
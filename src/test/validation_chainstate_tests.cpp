@@ -14,6 +14,7 @@
 #include <uint256.h>
 #include <validation.h>
 
+#include <thread>
 #include <vector>
 
 #include <boost/test/unit_test.hpp>
@@ -140,4 +141,67 @@ BOOST_FIXTURE_TEST_CASE(chainstate_update_tip, TestChain100Setup)
     BOOST_CHECK_EQUAL(curr_tip, ::g_best_block);
 }
 
+//! Test that PrefetchCoins() reads the coins a block spends into the coins cache.
+BOOST_FIXTURE_TEST_CASE(chainstate_prefetch_coins, TestingSetup)
+{
+    ChainstateManager& chainman = *Assert(m_node.chainman);
+    Chainstate& chainstate = chainman.ActiveChainstate();
+    StartCoinsPrefetchWorkerThreads(2);
+
+    // Write a coin to the coins database, and empty the coins cache.
+    const COutPoint spent{InsecureRand256(), 0};
+    const COutPoint missing{InsecureRand256(), 0};
+    const CAmount value{1 * COIN};
+    WITH_LOCK(::cs_main, chainstate.CoinsTip().AddCoin(spent, Coin{CTxOut{value, CScript{} << OP_TRUE}, 1, false}, /*possible_overwrite=*/false));
+    chainstate.ForceFlushStateToDisk();
+    WITH_LOCK(::cs_main, chainstate.WaitForCoinsWrite());
+
+    CMutableTransaction tx;
+    tx.vin = {CTxIn{spent}, CTxIn{missing}};
+    tx.vout.emplace_back(value - 1000, CScript{} << OP_TRUE);
+    // Coins created by the block itself are not read.
+    CMutableTransaction child;
+    child.vin.emplace_back(COutPoint{tx.GetHash(), 0});
+    child.vout.emplace_back(tx.vout[0].nValue - 1000, CScript{} << OP_TRUE);
+    CBlock block;
+    block.vtx = {MakeTransactionRef(tx), MakeTransactionRef(child)};
+
+    BOOST_REQUIRE(!WITH_LOCK(::cs_main, return chainstate.CoinsTip().HaveCoinInCache(spent)));
+    chainman.PrefetchCoins(block);
+    {
+        LOCK(::cs_main);
+        BOOST_CHECK(chainstate.CoinsTip().HaveCoinInCache(spent));
+        const uint64_t base_reads{chainstate.CoinsTip().GetBaseReads()};
+        BOOST_CHECK(!chainstate.CoinsTip().AccessCoin(spent).IsSpent());
+        BOOST_CHECK_EQUAL(chainstate.CoinsTip().GetBaseReads(), base_reads);
+
+        const CoinsPrefetchStats& stats{chainman.m_prefetch_stats};
+        BOOST_CHECK_EQUAL(stats.blocks, 1U);
+        BOOST_CHECK_EQUAL(stats.prevouts, 2U);
+        BOOST_CHECK_EQUAL(stats.cached, 0U);
+        BOOST_CHECK_EQUAL(stats.warmed, 1U);
+        BOOST_CHECK_EQUAL(stats.missing, 1U);
+        BOOST_CHECK_EQUAL(stats.discarded, 0U);
+    }
+
+    // Coins in the cache are not read again.
+    chainman.PrefetchCoins(block);
+    {
+        LOCK(::cs_main);
+        const CoinsPrefetchStats& stats{chainman.m_prefetch_stats};
+        BOOST_CHECK_EQUAL(stats.blocks, 2U);
+        BOOST_CHECK_EQUAL(stats.cached, 1U);
+        BOOST_CHECK_EQUAL(stats.warmed, 1U);
+        BOOST_CHECK_EQUAL(stats.missing, 2U);
+    }
+
+    // Resizing the caches waits for the reads to be done.
+    std::thread prefetch{[&] { chainman.PrefetchCoins(block); }};
+    WITH_LOCK(::cs_main, chainstate.ResizeCoinsCaches(1 << 20, 1 << 20));
+    prefetch.join();
+    BOOST_CHECK_EQUAL(WITH_LOCK(::cs_main, return chainman.m_prefetch_stats.blocks), 3U);
+
+    StopCoinsPrefetchWorkerThreads();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -2,14 +2,19 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <arith_uint256.h>
 #include <chainparams.h>
 #include <consensus/amount.h>
+#include <consensus/consensus.h>
+#include <consensus/merkle.h>
 #include <net.h>
+#include <pow.h>
 #include <signet.h>
 #include <uint256.h>
 #include <util/chaintype.h>
 #include <validation.h>
 
+#include <test/util/mining.h>
 #include <test/util/setup_common.h>
 
 #include <boost/test/unit_test.hpp>
@@ -145,4 +150,171 @@ BOOST_AUTO_TEST_CASE(test_assumeutxo)
     BOOST_CHECK_EQUAL(out110_2.nChainTx, 111U);
 }
 
+//! Test that batched header PoW checks on the worker threads agree with the serial checks.
+BOOST_AUTO_TEST_CASE(headers_pow_parallel)
+{
+    // Use an easy target so the whole batch gets hashed.
+    Consensus::Params consensus{Params().GetConsensus()};
+    consensus.powLimit = uint256S("ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+
+    const auto make_headers{[](uint32_t bad_index) {
+        std::vector<CBlockHeader> headers(16);
+        for (uint32_t i = 0; i < headers.size(); ++i) {
+            headers[i].nVersion = 1;
+            headers[i].nTime = i;
+            headers[i].nBits = i == bad_index ? 0 : 0x2100ffff;
+            headers[i].nNonce = i;
+        }
+        return headers;
+    }};
+
+    const std::vector<CBlockHeader> headers{make_headers(std::numeric_limits<uint32_t>::max())};
+
+    // The headers are fixed, and all of them meet the easy target.
+    for (const CBlockHeader& header : headers) {
+        BOOST_REQUIRE(CheckProofOfWork(header.GetPoWHash(), header.nBits, consensus));
+    }
+    BOOST_CHECK(HasValidProofOfWork(headers, consensus));
+    // Every hash was computed on a worker and memoized.
+    for (const CBlockHeader& header : headers) {
+        BOOST_CHECK(GetMemoizedPoWHash(header.GetHash()) == header.GetPoWHash());
+    }
+
+    // A single header with an invalid target fails the whole batch.
+    BOOST_CHECK(!HasValidProofOfWork(make_headers(headers.size() / 2), consensus));
+}
+
+//! Test that checking the transactions of a block in chunks on the block check
+//! threads reports the same first error as checking them in order.
+BOOST_AUTO_TEST_CASE(check_block_parallel)
+{
+    const Consensus::Params& consensus{Params().GetConsensus()};
+
+    const auto make_block{[](size_t ntx, int sigops_per_tx) {
+        CBlock block;
+        CMutableTransaction coinbase;
+        coinbase.vin.emplace_back();
+        coinbase.vin[0].scriptSig = CScript{} << OP_0 << OP_0;
+        coinbase.vout.emplace_back(0, CScript{});
+        block.vtx.push_back(MakeTransactionRef(std::move(coinbase)));
+        for (size_t i = 1; i < ntx; ++i) {
+            CMutableTransaction tx;
+            tx.vin.emplace_back(COutPoint{ArithToUint256(i), 0});
+            CScript script;
+            for (int j = 0; j < sigops_per_tx; j += MAX_PUBKEYS_PER_MULTISIG) script << OP_CHECKMULTISIG;
+            tx.vout.emplace_back(0, script);
+            block.vtx.push_back(MakeTransactionRef(std::move(tx)));
+        }
+        block.hashMerkleRoot = BlockMerkleRoot(block);
+        return block;
+    }};
+    const auto make_invalid{[](CBlock& block, size_t index) {
+        CMutableTransaction tx{*block.vtx[index]};
+        tx.vout.clear();
+        block.vtx[index] = MakeTransactionRef(std::move(tx));
+    }};
+
+    std::vector<std::pair<CBlock, std::string>> blocks;
+    blocks.reserve(6);
+    blocks.emplace_back(make_block(200, 0), "");
+    blocks.emplace_back(make_block(40, 0), "");
+    // The checks are spread over chunks of transactions, but the first
+    // invalid transaction is reported.
+    blocks.emplace_back(make_block(200, 0), "bad-txns-vout-empty");
+    make_invalid(blocks.back().first, 150);
+    make_invalid(blocks.back().first, 70);
+    blocks.back().first.hashMerkleRoot = BlockMerkleRoot(blocks.back().first);
+    // Merkle root errors take precedence.
+    blocks.emplace_back(blocks.back().first, "bad-txnmrklroot");
+    blocks.back().first.hashMerkleRoot = uint256::ONE;
+    blocks.emplace_back(make_block(200, 0), "bad-txns-duplicate");
+    for (int i = 0; i < 8; ++i) blocks.back().first.vtx.push_back(blocks.back().first.vtx[192 + i]);
+    // Each chunk is within the sigop limit, but not the block.
+    blocks.emplace_back(make_block(200, MAX_BLOCK_SIGOPS_COST / WITNESS_SCALE_FACTOR / 150), "bad-blk-sigops");
+
+    const auto check_all{[&] {
+        std::vector<std::string> results;
+        for (const auto& [block, reason] : blocks) {
+            BlockValidationState state;
+            BOOST_CHECK_EQUAL(CheckBlock(block, state, consensus, /*fCheckPOW=*/false), reason.empty());
+            BOOST_CHECK_EQUAL(state.GetRejectReason(), reason);
+            results.push_back(state.ToString());
+        }
+        return results;
+    }};
+    const std::vector<std::string> parallel{check_all()};
+    StopBlockCheckWorkerThreads();
+    const std::vector<std::string> serial{check_all()};
+    StartBlockCheckWorkerThreads(2);
+    BOOST_CHECK(parallel == serial);
+}
+
+//! Test that a batch of headers is accepted up to the first one that fails
+//! the proof-of-work check done before cs_main is taken.
+BOOST_FIXTURE_TEST_CASE(process_new_block_headers_batch, RegTestingSetup)
+{
+    ChainstateManager& chainman{*m_node.chainman};
+    const CBlock& genesis{chainman.GetParams().GenesisBlock()};
+
+    const uint256 high_hash{uint256S("ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff")};
+    std::vector<CBlockHeader> headers(4);
+    uint256 prev_hash{genesis.GetHash()};
+    for (size_t i = 0; i < headers.size(); ++i) {
+        headers[i].nVersion = 0x20000000;
+        headers[i].hashPrevBlock = prev_hash;
+        headers[i].nTime = genesis.nTime + 60 * (i + 1);
+        headers[i].nBits = genesis.nBits;
+        prev_hash = headers[i].GetHash();
+        // The third header misses the target.
+        if (i == 2) {
+            MemoizePoWHash(prev_hash, high_hash);
+        } else {
+            MemoizeValidPoW(headers[i]);
+        }
+    }
+
+    BlockValidationState state;
+    const CBlockIndex* last_accepted{nullptr};
+    BOOST_CHECK(!chainman.ProcessNewBlockHeaders(headers, /*min_pow_checked=*/true, state, &last_accepted));
+    BOOST_CHECK_EQUAL(state.GetRejectReason(), "high-hash");
+    BOOST_REQUIRE(last_accepted);
+    BOOST_CHECK(last_accepted->GetBlockHash() == headers[1].GetHash());
+    LOCK(cs_main);
+    for (size_t i = 0; i < headers.size(); ++i) {
+        BOOST_CHECK_EQUAL(chainman.m_blockman.LookupBlockIndex(headers[i].GetHash()) != nullptr, i < 2);
+    }
+}
+
+//! Test that the proof of work of headers is not checked again when the
+//! caller has checked it, e.g. for headers redownloaded after a low-work
+//! headers sync, but is checked for the headers after those.
+BOOST_FIXTURE_TEST_CASE(process_new_block_headers_pow_checked, RegTestingSetup)
+{
+    ChainstateManager& chainman{*m_node.chainman};
+    const CBlock& genesis{chainman.GetParams().GenesisBlock()};
+
+    const uint256 high_hash{uint256S("ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff")};
+    std::vector<CBlockHeader> headers(2);
+    uint256 prev_hash{genesis.GetHash()};
+    for (size_t i = 0; i < headers.size(); ++i) {
+        headers[i].nVersion = 0x20000000;
+        headers[i].hashPrevBlock = prev_hash;
+        headers[i].nTime = genesis.nTime + 60 * (i + 1);
+        headers[i].nBits = genesis.nBits;
+        prev_hash = headers[i].GetHash();
+        MemoizePoWHash(prev_hash, high_hash);
+    }
+
+    BlockValidationState state;
+    BOOST_CHECK(!chainman.ProcessNewBlockHeaders({headers[0]}, /*min_pow_checked=*/true, state));
+    BOOST_CHECK_EQUAL(state.GetRejectReason(), "high-hash");
+
+    state = BlockValidationState{};
+    const CBlockIndex* last_accepted{nullptr};
+    BOOST_CHECK(!chainman.ProcessNewBlockHeaders(headers, /*min_pow_checked=*/true, state, &last_accepted, /*pow_checked=*/1));
+    BOOST_CHECK_EQUAL(state.GetRejectReason(), "high-hash");
+    BOOST_REQUIRE(last_accepted);
+    BOOST_CHECK(last_accepted->GetBlockHash() == headers[0].GetHash());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -8,14 +8,19 @@
 #include <coins.h>
 #include <dbwrapper.h>
 #include <logging.h>
+#include <memusage.h>
 #include <primitives/transaction.h>
 #include <random.h>
 #include <serialize.h>
 #include <uint256.h>
+#include <util/thread.h>
+#include <util/time.h>
 #include <util/vector.h>
 
 #include <cassert>
+#include <chrono>
 #include <cstdlib>
+#include <exception>
 #include <iterator>
 #include <utility>
 
@@ -226,3 +231,145 @@ void CCoinsViewDBCursor::Next()
         keyTmp.first = entry.key;
     }
 }
+
+CCoinsViewBackgroundWriter::CCoinsViewBackgroundWriter(CCoinsView* view)
+    : CCoinsViewBacked(view),
+      m_thread{&util::TraceThread, "coinswrite", [this] { ThreadWrite(); }} {}
+
+CCoinsViewBackgroundWriter::~CCoinsViewBackgroundWriter()
+{
+    WITH_LOCK(m_mutex, m_stop = true);
+    m_cv.notify_all();
+    m_thread.join();
+}
+
+bool CCoinsViewBackgroundWriter::GetCoin(const COutPoint &outpoint, Coin &coin) const
+{
+    {
+        LOCK(m_mutex);
+        if (m_writing || m_failed) {
+            if (const auto it{m_coins.find(outpoint)}; it != m_coins.end()) {
+                if (it->second.coin.IsSpent()) return false;
+                coin = it->second.coin;
+                return true;
+            }
+        }
+    }
+    // Coins that are not being written are not changed in the view below.
+    return base->GetCoin(outpoint, coin);
+}
+
+bool CCoinsViewBackgroundWriter::HaveCoin(const COutPoint &outpoint) const
+{
+    {
+        LOCK(m_mutex);
+        if (m_writing || m_failed) {
+            if (const auto it{m_coins.find(outpoint)}; it != m_coins.end()) {
+                return !it->second.coin.IsSpent();
+            }
+        }
+    }
+    return base->HaveCoin(outpoint);
+}
+
+uint256 CCoinsViewBackgroundWriter::GetBestBlock() const
+{
+    {
+        LOCK(m_mutex);
+        if (m_writing || m_failed) return m_block;
+    }
+    return base->GetBestBlock();
+}
+
+std::vector<uint256> CCoinsViewBackgroundWriter::GetHeadBlocks() const
+{
+    WaitForWrite();
+    return base->GetHeadBlocks();
+}
+
+std::unique_ptr<CCoinsViewCursor> CCoinsViewBackgroundWriter::Cursor() const
+{
+    WaitForWrite();
+    return base->Cursor();
+}
+
+bool CCoinsViewBackgroundWriter::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, bool erase)
+{
+    {
+        WAIT_LOCK(m_mutex, lock);
+        m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return !m_writing; });
+        if (m_failed) return false;
+        if (erase) {
+            // Take over the whole map instead of copying the coins. The
+            // entries that are not dirty are skipped when writing.
+            m_coins = std::move(mapCoins);
+        } else {
+            for (const auto& [outpoint, entry] : mapCoins) {
+                if (entry.flags & CCoinsCacheEntry::DIRTY) m_coins.emplace(outpoint, entry);
+            }
+        }
+        m_coins_usage = memusage::DynamicUsage(m_coins);
+        for (const auto& [_, entry] : m_coins) {
+            m_coins_usage += entry.coin.DynamicMemoryUsage();
+        }
+        m_block = hashBlock;
+        m_writing = true;
+    }
+    m_cv.notify_all();
+    return true;
+}
+
+bool CCoinsViewBackgroundWriter::WaitForWrite() const
+{
+    WAIT_LOCK(m_mutex, lock);
+    m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return !m_writing; });
+    return !m_failed;
+}
+
+bool CCoinsViewBackgroundWriter::IsWriting() const
+{
+    return WITH_LOCK(m_mutex, return m_writing);
+}
+
+size_t CCoinsViewBackgroundWriter::DynamicMemoryUsage() const
+{
+    return WITH_LOCK(m_mutex, return m_coins_usage);
+}
+
+void CCoinsViewBackgroundWriter::ThreadWrite()
+{
+    while (true) {
+        {
+            WAIT_LOCK(m_mutex, lock);
+            m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_writing || m_stop; });
+            if (!m_writing) return;
+        }
+
+        const auto start{SteadyClock::now()};
+        bool ok{false};
+        try {
+            // Keep the coins until all of them are written, to serve them.
+            ok = base->BatchWrite(m_coins, m_block, /*erase=*/false);
+        } catch (const std::exception& e) {
+            LogPrintf("%s: %s\n", __func__, e.what());
+        }
+        if (ok) {
+            LogPrint(BCLog::COINDB, "Wrote %u cached coins in the background in %dms\n",
+                     m_coins.size(), Ticks<std::chrono::milliseconds>(SteadyClock::now() - start));
+        } else {
+            LogPrintLevel(BCLog::COINDB, BCLog::Level::Error, "Failed to write coins to the database, they are kept in memory\n");
+        }
+
+        {
+            LOCK(m_mutex);
+            if (ok) {
+                m_coins = CCoinsMap{};
+                m_coins_usage = 0;
+            } else {
+                m_failed = true;
+            }
+            m_writing = false;
+        }
+        m_cv.notify_all();
+    }
+}
@@ -12,10 +12,12 @@
 #include <sync.h>
 #include <util/fs.h>
 
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <optional>
+#include <thread>
 #include <vector>
 
 class COutPoint;
@@ -47,6 +49,9 @@ struct CoinsViewOptions {
     //! If non-zero, randomly exit when the database is flushed with (1/ratio)
     //! probability.
     int simulate_crash_ratio = 0;
+    //! Whether flushes that are not forced are written to the database in
+    //! the background, see CCoinsViewBackgroundWriter.
+    bool background_flush = true;
 };
 
 /** CCoinsView backed by the coin database (chainstate/) */
@@ -77,4 +82,58 @@ public:
     std::optional<fs::path> StoragePath() { return m_db->StoragePath(); }
 };
 
+/**
+ * CCoinsView that writes the coins flushed to it to the view below on a
+ * background thread, so that flushing a large coins cache does not stall
+ * everything waiting for cs_main while the database is written.
+ *
+ * Until they are written, the coins are served from memory. A further flush
+ * waits for the previous one to be written. Should the node go down halfway,
+ * CCoinsViewDB::BatchWrite's head blocks markers let the next start replay
+ * the blocks that were being flushed.
+ */
+class CCoinsViewBackgroundWriter final : public CCoinsViewBacked
+{
+public:
+    explicit CCoinsViewBackgroundWriter(CCoinsView* view);
+    ~CCoinsViewBackgroundWriter();
+
+    bool GetCoin(const COutPoint &outpoint, Coin &coin) const override;
+    bool HaveCoin(const COutPoint &outpoint) const override;
+    uint256 GetBestBlock() const override;
+    std::vector<uint256> GetHeadBlocks() const override;
+    bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, bool erase = true) override;
+    std::unique_ptr<CCoinsViewCursor> Cursor() const override;
+
+    //! Wait until the coins passed to BatchWrite have been written.
+    //! @returns false if writing them failed.
+    bool WaitForWrite() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    //! Whether coins are being written.
+    bool IsWriting() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    //! Memory held by the coins that are being written.
+    size_t DynamicMemoryUsage() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    mutable Mutex m_mutex;
+    mutable std::condition_variable m_cv;
+
+    //! The coins being written and the block they are for. They are only
+    //! modified with m_mutex held while no write is in progress, so the
+    //! writing thread reads them without it.
+    CCoinsMap m_coins;
+    uint256 m_block;
+
+    size_t m_coins_usage GUARDED_BY(m_mutex){0};
+    bool m_writing GUARDED_BY(m_mutex){false};
+    //! Writing failed. The coins stay in memory, and no more are accepted.
+    bool m_failed GUARDED_BY(m_mutex){false};
+    bool m_stop GUARDED_BY(m_mutex){false};
+
+    std::thread m_thread;
+
+    void ThreadWrite() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+
 #endif // BITCOIN_TXDB_H
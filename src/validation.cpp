@@ -38,7 +38,6 @@
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <random.h>
-#include <reverse_iterator.h>
 #include <script/script.h>
 #include <script/sigcache.h>
 #include <signet.h>
@@ -104,6 +103,9 @@ const std::vector<std::string> CHECKLEVEL_DOC {
  *  noticeably interfere with the pruning mechanism.
  * */
 static constexpr int PRUNE_LOCK_BUFFER{10};
+/** Maximum number of blocks connected at once during initial block download,
+ *  so that the script checks of one overlap with connecting the next. */
+static constexpr size_t MAX_PIPELINED_BLOCKS{8};
 
 GlobalMutex g_best_block_mutex;
 std::condition_variable g_best_block_cv;
@@ -1649,8 +1651,10 @@ CAmount GetBlockSubsidy(int nHeight, const Consensus::Params& consensusParams)
 }
 
 CoinsViews::CoinsViews(DBParams db_params, CoinsViewOptions options)
-    : m_dbview{std::move(db_params), std::move(options)},
-      m_catcherview(&m_dbview) {}
+    : m_dbview{std::move(db_params), options},
+      m_writerview(&m_dbview),
+      m_catcherview(&m_writerview),
+      m_background_flush{options.background_flush} {}
 
 void CoinsViews::InitCache()
 {
@@ -2061,6 +2065,14 @@ DisconnectResult Chainstate::DisconnectBlock(const CBlock& block, const CBlockIn
 
 static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
 
+/** The script checks of blocks connected to a view one after another, which
+ *  are only waited for once all of them are. */
+struct DeferredScriptChecks {
+    //! Referenced by the queued checks. Declared first so it outlives control.
+    std::vector<std::vector<PrecomputedTransactionData>> txsdata;
+    CCheckQueueControl<CScriptCheck> control{&scriptcheckqueue};
+};
+
 void StartScriptCheckWorkerThreads(int threads_num)
 {
     scriptcheckqueue.StartWorkerThreads(threads_num);
@@ -2071,6 +2083,155 @@ void StopScriptCheckWorkerThreads()
     scriptcheckqueue.StopWorkerThreads();
 }
 
+/**
+ * Closure representing the proof-of-work check of a single block header.
+ * The yespower hash is computed on whichever thread runs the check, using
+ * that thread's own yespower_tls() region, and is memoized (see
+ * GetMemoizedPoWHash()) so later validation does not recompute it.
+ */
+class CHeaderPoWCheck
+{
+private:
+    const CBlockHeader* m_header;
+    const Consensus::Params* m_params;
+
+public:
+    CHeaderPoWCheck(const CBlockHeader& header, const Consensus::Params& params)
+        : m_header(&header), m_params(&params) {}
+
+    bool operator()()
+    {
+        return CheckProofOfWork(m_header->GetPoWHash_cached(), m_header->nBits, *m_params);
+    }
+};
+
+// A single yespower hash takes milliseconds, so keep the batches small to
+// spread a headers message evenly over the workers.
+static CCheckQueue<CHeaderPoWCheck> headerpowcheckqueue(8, "headerpow");
+
+//! CheckBlock() checks the transactions of larger blocks in chunks of this many.
+static constexpr unsigned int BLOCK_CHECK_CHUNK_DEPTH{6};
+static constexpr size_t BLOCK_CHECK_CHUNK_SIZE{size_t{1} << BLOCK_CHECK_CHUNK_DEPTH};
+
+/**
+ * Closure representing the context-free checks of a chunk of the transactions
+ * of a block: CheckTransaction(), the legacy sigop count and the root of the
+ * chunk's subtree of the Merkle tree. It records its results instead of
+ * failing, so CheckBlock() reports the same first error as when checking the
+ * transactions in order.
+ */
+class CBlockChunkCheck
+{
+public:
+    struct Result {
+        uint256 merkle_root;
+        bool mutated{false};
+        unsigned int sigops{0};
+        //! The first transaction of the chunk that failed CheckTransaction(), if any.
+        std::optional<size_t> failed_tx;
+        TxValidationState tx_state;
+    };
+
+private:
+    const CBlock* m_block;
+    size_t m_begin;
+    bool m_check_merkle_root;
+    Result* m_result;
+
+public:
+    CBlockChunkCheck(const CBlock& block, size_t begin, bool check_merkle_root, Result& result)
+        : m_block(&block), m_begin(begin), m_check_merkle_root(check_merkle_root), m_result(&result) {}
+
+    bool operator()()
+    {
+        if (m_check_merkle_root) {
+            m_result->merkle_root = BlockMerkleSubtreeRoot(*m_block, m_begin, BLOCK_CHECK_CHUNK_DEPTH, &m_result->mutated);
+        }
+        const size_t end{std::min(m_block->vtx.size(), m_begin + BLOCK_CHECK_CHUNK_SIZE)};
+        for (size_t i = m_begin; i < end; ++i) {
+            const CTransaction& tx{*m_block->vtx[i]};
+            if (!m_result->failed_tx && !CheckTransaction(tx, m_result->tx_state)) {
+                m_result->failed_tx = i;
+            }
+            m_result->sigops += GetLegacySigOpCount(tx);
+        }
+        return true;
+    }
+};
+
+// Every check covers a whole chunk, so let workers take one at a time.
+static CCheckQueue<CBlockChunkCheck> blockcheckqueue(1, "blockcheck");
+// Whether CheckBlock() spreads the transactions over the queue. Only a hint, as
+// the master runs whatever checks the workers leave while they stop.
+static std::atomic<int> g_block_check_threads{0};
+
+void StartBlockCheckWorkerThreads(int threads_num)
+{
+    blockcheckqueue.StartWorkerThreads(threads_num);
+    g_block_check_threads = threads_num;
+}
+
+void StopBlockCheckWorkerThreads()
+{
+    g_block_check_threads = 0;
+    blockcheckqueue.StopWorkerThreads();
+}
+
+/**
+ * Closure reading a coin from the coins database ahead of connecting the block
+ * that spends it, see ChainstateManager::PrefetchCoins().
+ */
+class CCoinsPrefetch
+{
+private:
+    const CCoinsView* m_view;
+    const COutPoint* m_outpoint;
+    std::optional<Coin>* m_coin;
+
+public:
+    CCoinsPrefetch(const CCoinsView& view, const COutPoint& outpoint, std::optional<Coin>& coin)
+        : m_view(&view), m_outpoint(&outpoint), m_coin(&coin) {}
+
+    bool operator()()
+    {
+        Coin coin;
+        if (m_view->GetCoin(*m_outpoint, coin)) *m_coin = std::move(coin);
+        return true;
+    }
+};
+
+// Reads are waits for the disk, so batches are small to keep them all going.
+static CCheckQueue<CCoinsPrefetch> coinsprefetchqueue(16, "prefetch");
+// Checked by the threads calling PrefetchCoins(), which may race with shutdown.
+static std::atomic<int> g_coins_prefetch_threads{0};
+
+void StartCoinsPrefetchWorkerThreads(int threads_num)
+{
+    coinsprefetchqueue.StartWorkerThreads(threads_num);
+    g_coins_prefetch_threads = threads_num;
+}
+
+void StopCoinsPrefetchWorkerThreads()
+{
+    g_coins_prefetch_threads = 0;
+    coinsprefetchqueue.StopWorkerThreads();
+}
+
+int GetCoinsPrefetchWorkerThreads()
+{
+    return g_coins_prefetch_threads;
+}
+
+void StartHeaderPoWCheckWorkerThreads(int threads_num)
+{
+    headerpowcheckqueue.StartWorkerThreads(threads_num);
+}
+
+void StopHeaderPoWCheckWorkerThreads()
+{
+    headerpowcheckqueue.StopWorkerThreads();
+}
+
 /**
  * Threshold condition checker that triggers when unknown versionbits are seen on the network.
  */
@@ -2152,7 +2313,7 @@ static int64_t num_blocks_total = 0;
  *  Validity checks that depend on the UTXO set are also done; ConnectBlock()
  *  can fail if those validity checks fail (among other reasons). */
 bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state, CBlockIndex* pindex,
-                               CCoinsViewCache& view, bool fJustCheck)
+                               CCoinsViewCache& view, bool fJustCheck, DeferredScriptChecks* deferred)
 {
     AssertLockHeld(cs_main);
     assert(pindex);
@@ -2359,14 +2520,18 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     // until after `control` has run the script checks (potentially
     // in multiple threads). Preallocate the vector size so a new allocation
     // doesn't invalidate pointers into the vector, and keep txsdata in scope
-    // for as long as `control`.
-    CCheckQueueControl<CScriptCheck> control(fScriptChecks && parallel_script_checks ? &scriptcheckqueue : nullptr);
-    std::vector<PrecomputedTransactionData> txsdata(block.vtx.size());
+    // for as long as `control`. Deferred checks keep their own.
+    CCheckQueueControl<CScriptCheck> block_control(fScriptChecks && parallel_script_checks && !deferred ? &scriptcheckqueue : nullptr);
+    std::vector<PrecomputedTransactionData> block_txsdata(deferred ? 0 : block.vtx.size());
+    CCheckQueueControl<CScriptCheck>& control{deferred ? deferred->control : block_control};
+    std::vector<PrecomputedTransactionData>& txsdata{deferred ? deferred->txsdata.emplace_back(block.vtx.size()) : block_txsdata};
 
     std::vector<int> prevheights;
     CAmount nFees = 0;
     int nInputs = 0;
     int64_t nSigOpsCost = 0;
+    // For the prefetch hit rate, see ChainstateManager::PrefetchCoins().
+    const uint64_t base_reads{CoinsTip().GetBaseReads()};
     blockundo.vtxundo.reserve(block.vtx.size() - 1);
     for (unsigned int i = 0; i < block.vtx.size(); i++)
     {
@@ -2449,7 +2614,7 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
         return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-cb-amount");
     }
 
-    if (!control.Wait()) {
+    if (!deferred && !control.Wait()) {
         LogPrintf("ERROR: %s: CheckQueue failed\n", __func__);
         return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "block-validation-failed");
     }
@@ -2464,6 +2629,9 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     if (fJustCheck)
         return true;
 
+    m_chainman.m_prefetch_stats.inputs += nInputs - block.vtx[0]->vin.size();
+    m_chainman.m_prefetch_stats.reads += CoinsTip().GetBaseReads() - base_reads;
+
     if (!m_blockman.WriteUndoDataForBlock(blockundo, state, *pindex)) {
         return false;
     }
@@ -2475,7 +2643,7 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
              Ticks<SecondsDouble>(time_undo),
              Ticks<MillisecondsDouble>(time_undo) / num_blocks_total);
 
-    if (!pindex->IsValid(BLOCK_VALID_SCRIPTS)) {
+    if (!deferred && !pindex->IsValid(BLOCK_VALID_SCRIPTS)) {
         pindex->RaiseValidity(BLOCK_VALID_SCRIPTS);
         m_blockman.m_dirty_blockindex.insert(pindex);
     }
@@ -2516,7 +2684,8 @@ CoinsCacheSizeState Chainstate::GetCoinsCacheSizeState(
 {
     AssertLockHeld(::cs_main);
     const int64_t nMempoolUsage = m_mempool ? m_mempool->DynamicMemoryUsage() : 0;
-    int64_t cacheSize = CoinsTip().DynamicMemoryUsage();
+    // Coins that are still being written count towards the limit too.
+    int64_t cacheSize = CoinsTip().DynamicMemoryUsage() + m_coins_views->m_writerview.DynamicMemoryUsage();
     int64_t nTotalSpace =
         max_coins_cache_size_bytes + std::max<int64_t>(int64_t(max_mempool_size_bytes) - nMempoolUsage, 0);
 
@@ -2604,7 +2773,8 @@ bool Chainstate::FlushStateToDisk(
             m_last_flush = nNow;
         }
         // The cache is large and we're within 10% and 10 MiB of the limit, but we have time now (not in the middle of a block processing).
-        bool fCacheLarge = mode == FlushStateMode::PERIODIC && cache_state >= CoinsCacheSizeState::LARGE;
+        // Unless the previous flush is still being written, which flushing again would wait for.
+        bool fCacheLarge = mode == FlushStateMode::PERIODIC && cache_state >= CoinsCacheSizeState::LARGE && !m_coins_views->m_writerview.IsWriting();
         // The cache is over the limit, we have to write now.
         bool fCacheCritical = mode == FlushStateMode::IF_NEEDED && cache_state >= CoinsCacheSizeState::CRITICAL;
         // It's been a while since we wrote the block index to disk. Do this frequently, so we don't need to redownload after a crash.
@@ -2662,6 +2832,13 @@ bool Chainstate::FlushStateToDisk(
             // Flush the chainstate (which may refer to block index entries).
             if (!CoinsTip().Flush())
                 return FatalError(m_chainman.GetNotifications(), state, "Failed to write to coin database");
+            // Unless the flush is forced or for pruning, the coins are
+            // written in the background, without holding cs_main.
+            if (mode == FlushStateMode::ALWAYS || fFlushForPrune || !m_coins_views->m_background_flush) {
+                if (!WaitForCoinsWrite()) {
+                    return FatalError(m_chainman.GetNotifications(), state, "Failed to write to coin database");
+                }
+            }
             m_last_flush = nNow;
             full_flush_completed = true;
             TRACE5(utxocache, flush,
@@ -2991,6 +3168,99 @@ bool Chainstate::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew,
     return true;
 }
 
+/**
+ * Connect a run of blocks to m_chain like ConnectTip does for one of them, but
+ * with the script checks of each one running while the next one is connected.
+ * The blocks are applied to a single view, which is only flushed and made the
+ * tip once all of their scripts proved valid.
+ *
+ * If any of them turns out invalid, nothing is applied, and false is returned
+ * with state left valid: the caller then connects the blocks one by one with
+ * ConnectTip, which finds the invalid one.
+ */
+bool Chainstate::ConnectTips(BlockValidationState& state, const std::vector<CBlockIndex*>& blocks, CBlockIndex* pindexMostWork, const std::shared_ptr<const CBlock>& pblock, ConnectTrace& connectTrace, DisconnectedBlockTransactions& disconnectpool)
+{
+    AssertLockHeld(cs_main);
+    if (m_mempool) AssertLockHeld(m_mempool->cs);
+
+    assert(!blocks.empty() && blocks.front()->pprev == m_chain.Tip());
+    const auto time_1{SteadyClock::now()};
+    // Owns every block passed to ConnectBlock, as their queued script checks
+    // refer to the transactions in them until deferred.control is done.
+    std::vector<std::shared_ptr<const CBlock>> connected_blocks;
+    // The blocks are counted when connected one by one after a failure.
+    const CoinsPrefetchStats prefetch_stats{m_chainman.m_prefetch_stats};
+    bool valid{true};
+    {
+        CCoinsViewCache view(&CoinsTip());
+        DeferredScriptChecks deferred;
+        for (CBlockIndex* pindex : blocks) {
+            std::shared_ptr<const CBlock> pthisBlock{pindex == pindexMostWork ? pblock : nullptr};
+            if (!pthisBlock) {
+                std::shared_ptr<CBlock> pblockNew = std::make_shared<CBlock>();
+                if (!m_blockman.ReadBlockFromDisk(*pblockNew, *pindex)) {
+                    return FatalError(m_chainman.GetNotifications(), state, "Failed to read block");
+                }
+                pthisBlock = pblockNew;
+            }
+            connected_blocks.push_back(std::move(pthisBlock));
+            BlockValidationState block_state;
+            if (!ConnectBlock(*connected_blocks.back(), block_state, pindex, view, /*fJustCheck=*/false, &deferred)) {
+                if (!block_state.IsInvalid()) {
+                    // A system error, which connecting one by one would run into as well.
+                    // deferred waits for the queued checks before connected_blocks goes away.
+                    state = block_state;
+                    return error("%s: ConnectBlock %s failed, %s", __func__, pindex->GetBlockHash().ToString(), state.ToString());
+                }
+                valid = false;
+                break;
+            }
+        }
+        if (!deferred.control.Wait()) valid = false;
+        if (valid) {
+            bool flushed = view.Flush();
+            assert(flushed);
+        }
+    }
+    if (!valid) {
+        LogPrint(BCLog::VALIDATION, "%s: blocks %d to %d failed to connect together, connecting them one by one\n",
+                 __func__, blocks.front()->nHeight, blocks.back()->nHeight);
+        m_chainman.m_prefetch_stats = prefetch_stats;
+        return false;
+    }
+    const auto time_2{SteadyClock::now()};
+
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        if (!blocks[i]->IsValid(BLOCK_VALID_SCRIPTS)) {
+            blocks[i]->RaiseValidity(BLOCK_VALID_SCRIPTS);
+            m_blockman.m_dirty_blockindex.insert(blocks[i]);
+        }
+        GetMainSignals().BlockChecked(*connected_blocks[i], BlockValidationState{});
+    }
+    // Write the chain state to disk, if necessary.
+    if (!FlushStateToDisk(state, FlushStateMode::IF_NEEDED)) {
+        return false;
+    }
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        // Remove conflicting transactions from the mempool.
+        if (m_mempool) {
+            m_mempool->removeForBlock(connected_blocks[i]->vtx, blocks[i]->nHeight);
+            disconnectpool.removeForBlock(connected_blocks[i]->vtx);
+        }
+        // Update m_chain & related variables.
+        m_chain.SetTip(*blocks[i]);
+        UpdateTip(blocks[i]);
+        connectTrace.BlockConnected(blocks[i], std::move(connected_blocks[i]));
+    }
+
+    const auto time_3{SteadyClock::now()};
+    LogPrint(BCLog::BENCH, "- Connect %u blocks: %.2fms (%.2fms/blk), postprocess: %.2fms\n", (unsigned)blocks.size(),
+             Ticks<MillisecondsDouble>(time_2 - time_1),
+             Ticks<MillisecondsDouble>(time_2 - time_1) / blocks.size(),
+             Ticks<MillisecondsDouble>(time_3 - time_2));
+    return true;
+}
+
 /**
  * Return the tip of the chain with the most work in it, that isn't
  * known to be invalid (it's however far from certain to be valid).
@@ -3115,9 +3385,28 @@ bool Chainstate::ActivateBestChainStep(BlockValidationState& state, CBlockIndex*
         }
         nHeight = nTargetHeight;
 
-        // Connect new blocks.
-        for (CBlockIndex* pindexConnect : reverse_iterate(vpindexToConnect)) {
-            if (!ConnectTip(state, pindexConnect, pindexConnect == pindexMostWork ? pblock : std::shared_ptr<const CBlock>(), connectTrace, disconnectpool)) {
+        // Connect new blocks. During initial block download, connect several
+        // at once, so that the script check threads are not idle while the
+        // next block's inputs are looked up.
+        const bool pipelined{scriptcheckqueue.HasThreads() && m_chainman.IsInitialBlockDownload() &&
+                             this == &m_chainman.ActiveChainstate()};
+        // Blocks left to connect one by one, after they failed to connect together.
+        size_t serial{0};
+        for (auto it = vpindexToConnect.rbegin(); it != vpindexToConnect.rend();) {
+            const size_t count{pipelined && serial == 0 ? std::min<size_t>(MAX_PIPELINED_BLOCKS, vpindexToConnect.rend() - it) : 1};
+            bool connected;
+            if (count > 1) {
+                connected = ConnectTips(state, std::vector<CBlockIndex*>(it, it + count), pindexMostWork, pblock, connectTrace, disconnectpool);
+                if (!connected && state.IsValid()) {
+                    serial = count;
+                    continue;
+                }
+            } else {
+                connected = ConnectTip(state, *it, *it == pindexMostWork ? pblock : std::shared_ptr<const CBlock>(), connectTrace, disconnectpool);
+                if (serial > 0) --serial;
+            }
+            it += count;
+            if (!connected) {
                 if (state.IsInvalid()) {
                     // The block violates a consensus rule.
                     if (state.GetResult() != BlockValidationResult::BLOCK_MUTATED) {
@@ -3136,8 +3425,10 @@ bool Chainstate::ActivateBestChainStep(BlockValidationState& state, CBlockIndex*
                 }
             } else {
                 PruneBlockIndexCandidates();
-                if (!pindexOldTip || m_chain.Tip()->nChainWork > pindexOldTip->nChainWork) {
+                if (serial == 0 && (!pindexOldTip || m_chain.Tip()->nChainWork > pindexOldTip->nChainWork)) {
                     // We're in a better position than we were. Return temporarily to release the lock.
+                    // Blocks that failed to connect together are all connected first, so that they
+                    // are not connected together again.
                     fContinue = false;
                     break;
                 }
@@ -3656,10 +3947,41 @@ bool CheckBlock(const CBlock& block, BlockValidationState& state, const Consensu
         return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-signet-blksig", "signet block signature validation failure");
     }
 
+    // The transactions of larger blocks are checked on the block check
+    // threads, and the results reported in the same order as below.
+    std::vector<CBlockChunkCheck::Result> chunks;
+    if (block.vtx.size() > BLOCK_CHECK_CHUNK_SIZE && block.vtx.size() * WITNESS_SCALE_FACTOR <= MAX_BLOCK_WEIGHT && g_block_check_threads > 0) {
+        chunks.resize((block.vtx.size() + BLOCK_CHECK_CHUNK_SIZE - 1) / BLOCK_CHECK_CHUNK_SIZE);
+        std::vector<CBlockChunkCheck> checks;
+        checks.reserve(chunks.size());
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            checks.emplace_back(block, i * BLOCK_CHECK_CHUNK_SIZE, fCheckMerkleRoot, chunks[i]);
+        }
+        CCheckQueueControl<CBlockChunkCheck> control(&blockcheckqueue);
+        control.Add(std::move(checks));
+        // No worker writes into chunks once Wait() returns. If it reports a
+        // failure, their results can't be relied on, so check the
+        // transactions here instead.
+        if (!control.Wait()) chunks.clear();
+    }
+
     // Check the merkle root.
     if (fCheckMerkleRoot) {
         bool mutated;
-        uint256 hashMerkleRoot2 = BlockMerkleRoot(block, &mutated);
+        uint256 hashMerkleRoot2;
+        if (chunks.empty()) {
+            hashMerkleRoot2 = BlockMerkleRoot(block, &mutated);
+        } else {
+            std::vector<uint256> chunk_roots;
+            chunk_roots.reserve(chunks.size());
+            for (const auto& chunk : chunks) {
+                chunk_roots.push_back(chunk.merkle_root);
+            }
+            hashMerkleRoot2 = ComputeMerkleRoot(std::move(chunk_roots), &mutated);
+            for (const auto& chunk : chunks) {
+                mutated |= chunk.mutated;
+            }
+        }
         if (block.hashMerkleRoot != hashMerkleRoot2)
             return state.Invalid(BlockValidationResult::BLOCK_MUTATED, "bad-txnmrklroot", "hashMerkleRoot mismatch");
 
@@ -3687,22 +4009,31 @@ bool CheckBlock(const CBlock& block, BlockValidationState& state, const Consensu
         if (block.vtx[i]->IsCoinBase())
             return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-cb-multiple", "more than one coinbase");
 
+    const auto tx_invalid = [&](const CTransaction& tx, const TxValidationState& tx_state) {
+        // CheckBlock() does context-free validation checks. The only
+        // possible failures are consensus failures.
+        assert(tx_state.GetResult() == TxValidationResult::TX_CONSENSUS);
+        return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, tx_state.GetRejectReason(),
+                             strprintf("Transaction check failed (tx hash %s) %s", tx.GetHash().ToString(), tx_state.GetDebugMessage()));
+    };
+
     // Check transactions
     // Must check for duplicate inputs (see CVE-2018-17144)
-    for (const auto& tx : block.vtx) {
-        TxValidationState tx_state;
-        if (!CheckTransaction(*tx, tx_state)) {
-            // CheckBlock() does context-free validation checks. The only
-            // possible failures are consensus failures.
-            assert(tx_state.GetResult() == TxValidationResult::TX_CONSENSUS);
-            return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, tx_state.GetRejectReason(),
-                                 strprintf("Transaction check failed (tx hash %s) %s", tx->GetHash().ToString(), tx_state.GetDebugMessage()));
-        }
-    }
     unsigned int nSigOps = 0;
-    for (const auto& tx : block.vtx)
-    {
-        nSigOps += GetLegacySigOpCount(*tx);
+    if (chunks.empty()) {
+        for (const auto& tx : block.vtx) {
+            TxValidationState tx_state;
+            if (!CheckTransaction(*tx, tx_state)) return tx_invalid(*tx, tx_state);
+        }
+        for (const auto& tx : block.vtx)
+        {
+            nSigOps += GetLegacySigOpCount(*tx);
+        }
+    } else {
+        for (const auto& chunk : chunks) {
+            if (chunk.failed_tx) return tx_invalid(*block.vtx[*chunk.failed_tx], chunk.tx_state);
+            nSigOps += chunk.sigops;
+        }
     }
     if (nSigOps * WITNESS_SCALE_FACTOR > MAX_BLOCK_SIGOPS_COST)
         return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-blk-sigops", "out-of-bounds SigOpCount");
@@ -3713,6 +4044,30 @@ bool CheckBlock(const CBlock& block, BlockValidationState& state, const Consensu
     return true;
 }
 
+bool CheckWitnessCommitment(const CBlock& block, BlockValidationState& state)
+{
+    if (block.m_checked_witness_commitment) return true;
+
+    int commitpos = GetWitnessCommitmentIndex(block);
+    if (commitpos == NO_WITNESS_COMMITMENT) return true;
+
+    bool malleated = false;
+    uint256 hashWitness = BlockWitnessMerkleRoot(block, &malleated);
+    // The malleation check is ignored; as the transaction tree itself
+    // already does not permit it, it is impossible to trigger in the
+    // witness tree.
+    if (block.vtx[0]->vin[0].scriptWitness.stack.size() != 1 || block.vtx[0]->vin[0].scriptWitness.stack[0].size() != 32) {
+        return state.Invalid(BlockValidationResult::BLOCK_MUTATED, "bad-witness-nonce-size", strprintf("%s : invalid witness reserved value size", __func__));
+    }
+    CHash256().Write(hashWitness).Write(block.vtx[0]->vin[0].scriptWitness.stack[0]).Finalize(hashWitness);
+    if (memcmp(hashWitness.begin(), &block.vtx[0]->vout[commitpos].scriptPubKey[6], 32)) {
+        return state.Invalid(BlockValidationResult::BLOCK_MUTATED, "bad-witness-merkle-match", strprintf("%s : witness merkle commitment mismatch", __func__));
+    }
+
+    block.m_checked_witness_commitment = true;
+    return true;
+}
+
 void ChainstateManager::UpdateUncommittedBlockStructures(CBlock& block, const CBlockIndex* pindexPrev) const
 {
     int commitpos = GetWitnessCommitmentIndex(block);
@@ -3752,9 +4107,19 @@ std::vector<unsigned char> ChainstateManager::GenerateCoinbaseCommitment(CBlock&
     return commitment;
 }
 
-bool HasValidProofOfWork(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams)
+bool HasValidProofOfWork(Span<const CBlockHeader> headers, const Consensus::Params& consensusParams)
 {
-    return std::all_of(headers.cbegin(), headers.cend(),
+    if (headers.size() > 1 && headerpowcheckqueue.HasThreads()) {
+        std::vector<CHeaderPoWCheck> checks;
+        checks.reserve(headers.size());
+        for (const CBlockHeader& header : headers) {
+            checks.emplace_back(header, consensusParams);
+        }
+        CCheckQueueControl<CHeaderPoWCheck> control(&headerpowcheckqueue);
+        control.Add(std::move(checks));
+        return control.Wait();
+    }
+    return std::all_of(headers.begin(), headers.end(),
             [&](const auto& header) { return CheckProofOfWork(header.GetPoWHash_cached(), header.nBits, consensusParams);});
 }
 
@@ -3868,20 +4233,8 @@ static bool ContextualCheckBlock(const CBlock& block, BlockValidationState& stat
     //   multiple, the last one is used.
     bool fHaveWitness = false;
     if (DeploymentActiveAfter(pindexPrev, chainman, Consensus::DEPLOYMENT_SEGWIT)) {
-        int commitpos = GetWitnessCommitmentIndex(block);
-        if (commitpos != NO_WITNESS_COMMITMENT) {
-            bool malleated = false;
-            uint256 hashWitness = BlockWitnessMerkleRoot(block, &malleated);
-            // The malleation check is ignored; as the transaction tree itself
-            // already does not permit it, it is impossible to trigger in the
-            // witness tree.
-            if (block.vtx[0]->vin[0].scriptWitness.stack.size() != 1 || block.vtx[0]->vin[0].scriptWitness.stack[0].size() != 32) {
-                return state.Invalid(BlockValidationResult::BLOCK_MUTATED, "bad-witness-nonce-size", strprintf("%s : invalid witness reserved value size", __func__));
-            }
-            CHash256().Write(hashWitness).Write(block.vtx[0]->vin[0].scriptWitness.stack[0]).Finalize(hashWitness);
-            if (memcmp(hashWitness.begin(), &block.vtx[0]->vout[commitpos].scriptPubKey[6], 32)) {
-                return state.Invalid(BlockValidationResult::BLOCK_MUTATED, "bad-witness-merkle-match", strprintf("%s : witness merkle commitment mismatch", __func__));
-            }
+        if (GetWitnessCommitmentIndex(block) != NO_WITNESS_COMMITMENT) {
+            if (!CheckWitnessCommitment(block, state)) return false;
             fHaveWitness = true;
         }
     }
@@ -3909,11 +4262,15 @@ static bool ContextualCheckBlock(const CBlock& block, BlockValidationState& stat
 }
 
 bool ChainstateManager::AcceptBlockHeader(const CBlockHeader& block, BlockValidationState& state, CBlockIndex** ppindex, bool min_pow_checked)
+{
+    return AcceptBlockHeader(block, block.GetHash(), /*header_checked=*/false, state, ppindex, min_pow_checked);
+}
+
+bool ChainstateManager::AcceptBlockHeader(const CBlockHeader& block, const uint256& hash, bool header_checked, BlockValidationState& state, CBlockIndex** ppindex, bool min_pow_checked)
 {
     AssertLockHeld(cs_main);
 
     // Check for duplicate
-    uint256 hash = block.GetHash();
     BlockMap::iterator miSelf{m_blockman.m_block_index.find(hash)};
     if (hash != GetConsensus().hashGenesisBlock) {
         if (miSelf != m_blockman.m_block_index.end()) {
@@ -3928,7 +4285,7 @@ bool ChainstateManager::AcceptBlockHeader(const CBlockHeader& block, BlockValida
             return true;
         }
 
-        if (!CheckBlockHeader(block, state, GetConsensus())) {
+        if (!header_checked && !CheckBlockHeader(block, state, GetConsensus())) {
             LogPrint(BCLog::VALIDATION, "%s: Consensus::CheckBlockHeader: %s, %s\n", __func__, hash.ToString(), state.ToString());
             return false;
         }
@@ -4019,44 +4376,49 @@ bool ChainstateManager::AcceptBlockHeader(const CBlockHeader& block, BlockValida
 }
 
 // Exposed wrapper for AcceptBlockHeader
-bool ChainstateManager::ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, bool min_pow_checked, BlockValidationState& state, const CBlockIndex** ppindex)
+bool ChainstateManager::ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, bool min_pow_checked, BlockValidationState& state, const CBlockIndex** ppindex, size_t pow_checked)
 {
     AssertLockNotHeld(cs_main);
-    /* Yespower */
-    // Look for this block's header in the index like AcceptBlock() will
+
+    std::vector<uint256> hashes;
+    hashes.reserve(headers.size());
+    for (const CBlockHeader& header : headers) {
+        hashes.push_back(header.GetHash());
+    }
+    // Headers already in the block index are not checked again when they are
+    // accepted, so skip their proof of work.
+    std::vector<bool> known(headers.size());
     {
         LOCK(cs_main);
-
-        for (const CBlockHeader& header : headers) {
-            uint256 hash = header.GetHash();
-            BlockMap::iterator miSelf{m_blockman.m_block_index.find(hash)};
-            if (miSelf != m_blockman.m_block_index.end()) {
-                // Block header is already known
-                CBlockIndex* pindex = &(miSelf->second);
-                if (!header.cache_init && pindex->cache_init) {
-                    LOCK(header.cache_lock); // Probably unnecessary since no concurrent access to pblock is expected
-                    header.cache_init = true;
-                    header.cache_block_hash = pindex->cache_block_hash;
-                    header.cache_PoW_hash = pindex->cache_PoW_hash;
-                }
-            }
+        for (size_t i = 0; i < headers.size(); ++i) {
+            known[i] = m_blockman.LookupBlockIndex(hashes[i]) != nullptr;
         }
     }
-	
+
+    // Check the proof of work of the others, after the ones the caller
+    // checked, before taking cs_main again. Checking stops at the first
+    // failure: that header is checked again under the lock, after the ones
+    // before it have been accepted, so the result and the state reported are
+    // the same as when accepting header by header.
+    size_t headers_checked{std::min(pow_checked, headers.size())};
+    for (size_t i = headers_checked; i < headers.size(); ++i) {
+        BlockValidationState header_state;
+        if (!known[i] && !CheckBlockHeader(headers[i], header_state, GetConsensus())) break;
+        ++headers_checked;
+    }
+
     {
         LOCK(cs_main);
-        for (const CBlockHeader& header : headers) {
+        bool accepted{true};
+        for (size_t i = 0; i < headers.size() && accepted; ++i) {
             CBlockIndex *pindex = nullptr; // Use a temp pindex instead of ppindex to avoid a const_cast
-            bool accepted{AcceptBlockHeader(header, state, &pindex, min_pow_checked)};
-            CheckBlockIndex();
-
-            if (!accepted) {
-                return false;
-            }
-            if (ppindex) {
+            accepted = AcceptBlockHeader(headers[i], hashes[i], /*header_checked=*/i < headers_checked, state, &pindex, min_pow_checked);
+            if (accepted && ppindex) {
                 *ppindex = pindex;
             }
         }
+        CheckBlockIndex();
+        if (!accepted) return false;
     }
     if (NotifyHeaderTip(*this)) {
         if (IsInitialBlockDownload() && ppindex && *ppindex) {
@@ -4232,6 +4594,93 @@ bool ChainstateManager::ProcessNewBlock(const std::shared_ptr<const CBlock>& blo
     return true;
 }
 
+void ChainstateManager::PrefetchCoins(const CBlock& block)
+{
+    AssertLockNotHeld(cs_main);
+    if (g_coins_prefetch_threads == 0) return;
+
+    CCoinsViewCache* coins_tip;
+    const CCoinsView* coins_db;
+    uint64_t base_writes;
+    std::vector<COutPoint> outpoints;
+    {
+        LOCK(cs_main);
+        // A snapshot chainstate may be replaced while reading.
+        if (m_snapshot_chainstate) return;
+        const CBlockIndex* pindex{m_blockman.LookupBlockIndex(block.GetHash())};
+        if (pindex && (pindex->nStatus & BLOCK_HAVE_DATA)) return;
+
+        Chainstate& chainstate{ActiveChainstate()};
+        coins_tip = &chainstate.CoinsTip();
+        coins_db = &chainstate.CoinsErrorCatcher();
+        base_writes = coins_tip->GetBaseWrites();
+
+        std::unordered_set<uint256, SaltedTxidHasher> txids;
+        for (const auto& tx : block.vtx) {
+            txids.insert(tx->GetHash());
+        }
+        for (const auto& tx : block.vtx) {
+            if (tx->IsCoinBase()) continue;
+            for (const CTxIn& txin : tx->vin) {
+                if (txids.count(txin.prevout.hash)) continue;
+                ++m_prefetch_stats.prevouts;
+                if (coins_tip->HaveCoinInCache(txin.prevout)) {
+                    ++m_prefetch_stats.cached;
+                } else {
+                    outpoints.push_back(txin.prevout);
+                }
+            }
+        }
+        ++m_prefetch_stats.blocks;
+        if (outpoints.empty()) return;
+        // Keep the coins database from being resized or replaced until done.
+        LOCK(m_prefetch_mutex);
+        ++m_prefetch_reads;
+    }
+
+    std::vector<std::optional<Coin>> coins(outpoints.size());
+    bool read;
+    {
+        std::vector<CCoinsPrefetch> reads;
+        reads.reserve(outpoints.size());
+        for (size_t i = 0; i < outpoints.size(); ++i) {
+            reads.emplace_back(*coins_db, outpoints[i], coins[i]);
+        }
+        CCheckQueueControl<CCoinsPrefetch> control{&coinsprefetchqueue};
+        control.Add(std::move(reads));
+        read = control.Wait();
+    }
+    WITH_LOCK(m_prefetch_mutex, --m_prefetch_reads);
+    m_prefetch_cv.notify_all();
+    // The coins read can't be relied on then; they are read again when the
+    // block is connected.
+    if (!read) return;
+
+    LOCK(cs_main);
+    // A coin that is not in the cache has not been changed since the last
+    // flush, so the one read is still current unless the cache was flushed
+    // while reading.
+    const bool current{&ActiveChainstate().CoinsTip() == coins_tip && coins_tip->GetBaseWrites() == base_writes};
+    for (size_t i = 0; i < outpoints.size(); ++i) {
+        if (!coins[i]) {
+            ++m_prefetch_stats.missing;
+        } else if (!current) {
+            ++m_prefetch_stats.discarded;
+        } else if (coins_tip->WarmCoin(outpoints[i], std::move(*coins[i]))) {
+            ++m_prefetch_stats.warmed;
+        } else {
+            ++m_prefetch_stats.cached;
+        }
+    }
+}
+
+void ChainstateManager::WaitForCoinsPrefetch()
+{
+    AssertLockHeld(cs_main);
+    WAIT_LOCK(m_prefetch_mutex, lock);
+    m_prefetch_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_prefetch_mutex) { return m_prefetch_reads == 0; });
+}
+
 MempoolAcceptResult ChainstateManager::ProcessTransaction(const CTransactionRef& tx, bool test_accept)
 {
     AssertLockHeld(cs_main);
@@ -5110,6 +5559,9 @@ bool Chainstate::ResizeCoinsCaches(size_t coinstip_size, size_t coinsdb_size)
     size_t old_coinstip_size = m_coinstip_cache_size_bytes;
     m_coinstip_cache_size_bytes = coinstip_size;
     m_coinsdb_cache_size_bytes = coinsdb_size;
+    // Resizing reopens the database, which must not be written or read meanwhile.
+    WaitForCoinsWrite();
+    m_chainman.WaitForCoinsPrefetch();
     CoinsDB().ResizeCache(coinsdb_size);
 
     LogPrintf("[%s] resized coinsdb cache to %.1f MiB\n",
@@ -5329,6 +5781,7 @@ bool ChainstateManager::ActivateSnapshot(
     }
 
     assert(!m_snapshot_chainstate);
+    WaitForCoinsPrefetch();
     m_snapshot_chainstate.swap(snapshot_chainstate);
     const bool chaintip_loaded = m_snapshot_chainstate->LoadChainTip();
     assert(chaintip_loaded);
@@ -5512,7 +5965,7 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
 
     // As above, okay to immediately release cs_main here since no other context knows
     // about the snapshot_chainstate.
-    CCoinsViewDB* snapshot_coinsdb = WITH_LOCK(::cs_main, return &snapshot_chainstate.CoinsDB());
+    CCoinsViewDB* snapshot_coinsdb = WITH_LOCK(::cs_main, snapshot_chainstate.WaitForCoinsWrite(); return &snapshot_chainstate.CoinsDB());
 
     std::optional<CCoinsStats> maybe_stats;
 
@@ -24,6 +24,7 @@
 #include <policy/packages.h>
 #include <policy/policy.h>
 #include <script/script_error.h>
+#include <span.h>
 #include <sync.h>
 #include <txdb.h>
 #include <txmempool.h> // For CTxMemPool::cs
@@ -66,9 +67,16 @@ class SignalInterrupt;
 } // namespace util
 
 /** Maximum number of dedicated script-checking threads allowed */
-static const int MAX_SCRIPTCHECK_THREADS = 15;
+static const int MAX_SCRIPTCHECK_THREADS = 127;
+/** Maximum number of dedicated header proof-of-work checking threads allowed. Each of them keeps
+ *  a yespower region of ~8 MiB for the lifetime of the process. */
+static const int MAX_HEADER_POW_CHECK_THREADS = 15;
 /** -par default (number of script-checking threads, 0 = auto) */
 static const int DEFAULT_SCRIPTCHECK_THREADS = 0;
+/** Maximum number of threads reading the coins spent by received blocks ahead of connecting them */
+static const int MAX_COINS_PREFETCH_THREADS = 64;
+/** -prefetchthreads default. Reading is mostly waiting for the disk, so this does not depend on the number of cores. */
+static const int DEFAULT_COINS_PREFETCH_THREADS = 4;
 /** Block files containing a block-height within MIN_BLOCKS_TO_KEEP of ActiveChain().Tip() will not be pruned. */
 static const unsigned int MIN_BLOCKS_TO_KEEP = 288;
 static const signed int DEFAULT_CHECKBLOCKS = 6;
@@ -102,6 +110,20 @@ extern const std::vector<std::string> CHECKLEVEL_DOC;
 void StartScriptCheckWorkerThreads(int threads_num);
 /** Stop all of the script checking worker threads */
 void StopScriptCheckWorkerThreads();
+/** Run instances of header proof-of-work checking worker threads */
+void StartHeaderPoWCheckWorkerThreads(int threads_num);
+/** Stop all of the header proof-of-work checking worker threads */
+void StopHeaderPoWCheckWorkerThreads();
+/** Run instances of block transaction checking worker threads, see CheckBlock() */
+void StartBlockCheckWorkerThreads(int threads_num);
+/** Stop all of the block transaction checking worker threads */
+void StopBlockCheckWorkerThreads();
+/** Run instances of coins prefetching worker threads, see ChainstateManager::PrefetchCoins() */
+void StartCoinsPrefetchWorkerThreads(int threads_num);
+/** Stop all of the coins prefetching worker threads */
+void StopCoinsPrefetchWorkerThreads();
+/** Number of running coins prefetching worker threads */
+int GetCoinsPrefetchWorkerThreads();
 
 CAmount GetBlockSubsidy(int nHeight, const Consensus::Params& consensusParams);
 
@@ -347,6 +369,11 @@ static_assert(std::is_nothrow_destructible_v<CScriptCheck>);
 /** Context-independent validity checks */
 bool CheckBlock(const CBlock& block, BlockValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true, bool fCheckMerkleRoot = true);
 
+/** Check the witness commitment of a block that has one against its transactions. This is the
+ *  context-free part of the witness checks in ContextualCheckBlock, which skips it for blocks
+ *  that already passed (block.m_checked_witness_commitment). */
+bool CheckWitnessCommitment(const CBlock& block, BlockValidationState& state);
+
 /** Check a block is completely valid from start to finish (only works on top of our current best block) */
 bool TestBlockValidity(BlockValidationState& state,
                        const CChainParams& chainparams,
@@ -357,8 +384,10 @@ bool TestBlockValidity(BlockValidationState& state,
                        bool fCheckPOW = true,
                        bool fCheckMerkleRoot = true) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
-/** Check with the proof of work on each blockheader matches the value in nBits */
-bool HasValidProofOfWork(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams);
+/** Check with the proof of work on each blockheader matches the value in nBits.
+ * When header proof-of-work worker threads are running, the yespower hashes of
+ * a batch are computed in parallel and memoized (see GetMemoizedPoWHash()). */
+bool HasValidProofOfWork(Span<const CBlockHeader> headers, const Consensus::Params& consensusParams);
 
 /** Return the sum of the work on a given set of headers */
 arith_uint256 CalculateHeadersWork(const std::vector<CBlockHeader>& headers);
@@ -396,6 +425,7 @@ enum DisconnectResult
 };
 
 class ConnectTrace;
+struct DeferredScriptChecks;
 
 /** @see Chainstate::FlushStateToDisk */
 enum class FlushStateMode {
@@ -421,14 +451,21 @@ public:
     //! All unspent coins reside in this store.
     CCoinsViewDB m_dbview GUARDED_BY(cs_main);
 
+    //! This view writes the coins flushed to it to m_dbview in the background.
+    CCoinsViewBackgroundWriter m_writerview;
+
     //! This view wraps access to the leveldb instance and handles read errors gracefully.
     CCoinsViewErrorCatcher m_catcherview GUARDED_BY(cs_main);
 
+    //! Whether flushes that are not forced may complete in the background.
+    const bool m_background_flush;
+
     //! This is the top layer of the cache hierarchy - it keeps as many coins in memory as
     //! can fit per the dbcache setting.
     std::unique_ptr<CCoinsViewCache> m_cacheview GUARDED_BY(cs_main);
 
-    //! This constructor initializes CCoinsViewDB and CCoinsViewErrorCatcher instances, but it
+    //! This constructor initializes the CCoinsViewDB, CCoinsViewBackgroundWriter and
+    //! CCoinsViewErrorCatcher instances, but it
     //! *does not* create a CCoinsViewCache instance by default. This is done separately because the
     //! presence of the cache has implications on whether or not we're allowed to flush the cache's
     //! state to disk, which should not be done until the health of the database is verified.
@@ -583,6 +620,14 @@ public:
         return Assert(m_coins_views)->m_dbview;
     }
 
+    //! Wait for the coins flushed from CoinsTip() to be written to CoinsDB().
+    //! @returns false if writing them failed.
+    bool WaitForCoinsWrite() EXCLUSIVE_LOCKS_REQUIRED(::cs_main)
+    {
+        AssertLockHeld(::cs_main);
+        return Assert(m_coins_views)->m_writerview.WaitForWrite();
+    }
+
     //! @returns A pointer to the mempool.
     CTxMemPool* GetMempool()
     {
@@ -667,8 +712,14 @@ public:
     // Block (dis)connection on a given view:
     DisconnectResult DisconnectBlock(const CBlock& block, const CBlockIndex* pindex, CCoinsViewCache& view)
         EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+    /**
+     * Apply a block to view. If deferred is not null, the block's script checks
+     * are added to it instead of being waited for, and it is up to the caller to
+     * wait for them and to mark the block BLOCK_VALID_SCRIPTS.
+     */
     bool ConnectBlock(const CBlock& block, BlockValidationState& state, CBlockIndex* pindex,
-                      CCoinsViewCache& view, bool fJustCheck = false) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+                      CCoinsViewCache& view, bool fJustCheck = false,
+                      DeferredScriptChecks* deferred = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     // Apply the effects of a block disconnection on the UTXO set.
     bool DisconnectTip(BlockValidationState& state, DisconnectedBlockTransactions* disconnectpool) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_mempool->cs);
@@ -730,6 +781,7 @@ public:
 private:
     bool ActivateBestChainStep(BlockValidationState& state, CBlockIndex* pindexMostWork, const std::shared_ptr<const CBlock>& pblock, bool& fInvalidFound, ConnectTrace& connectTrace) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_mempool->cs);
     bool ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew, const std::shared_ptr<const CBlock>& pblock, ConnectTrace& connectTrace, DisconnectedBlockTransactions& disconnectpool) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_mempool->cs);
+    bool ConnectTips(BlockValidationState& state, const std::vector<CBlockIndex*>& blocks, CBlockIndex* pindexMostWork, const std::shared_ptr<const CBlock>& pblock, ConnectTrace& connectTrace, DisconnectedBlockTransactions& disconnectpool) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_mempool->cs);
 
     void InvalidBlockFound(CBlockIndex* pindex, const BlockValidationState& state) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     CBlockIndex* FindMostWorkChain() EXCLUSIVE_LOCKS_REQUIRED(cs_main);
@@ -794,6 +846,26 @@ enum class SnapshotCompletionResult {
     BASE_BLOCKHASH_MISMATCH,
 };
 
+/** Counters of ChainstateManager::PrefetchCoins(), and of the coins cache while connecting blocks. */
+struct CoinsPrefetchStats {
+    //! Blocks whose coins were prefetched.
+    uint64_t blocks{0};
+    //! Coins spent by those blocks, other than ones created by the same block.
+    uint64_t prevouts{0};
+    //! Of those, the ones that were in the coins cache already.
+    uint64_t cached{0};
+    //! The ones read from the coins database and added to the coins cache.
+    uint64_t warmed{0};
+    //! The ones not found, usually as created by blocks not connected yet.
+    uint64_t missing{0};
+    //! The ones read, but dropped as the coins cache was flushed meanwhile.
+    uint64_t discarded{0};
+    //! Inputs of connected blocks.
+    uint64_t inputs{0};
+    //! Coins read from the coins database while connecting blocks.
+    uint64_t reads{0};
+};
+
 /**
  * Provides an interface for creating and interacting with one or two
  * chainstates: an IBD chainstate generated by downloading blocks, and
@@ -860,6 +932,12 @@ private:
 
     CBlockIndex* m_best_invalid GUARDED_BY(::cs_main){nullptr};
 
+    Mutex m_prefetch_mutex;
+    std::condition_variable m_prefetch_cv;
+    //! PrefetchCoins() calls reading from the coins database of the active
+    //! chainstate, which they do without holding cs_main.
+    int m_prefetch_reads GUARDED_BY(m_prefetch_mutex){0};
+
     //! Internal helper for ActivateSnapshot().
     [[nodiscard]] bool PopulateAndValidateSnapshot(
         Chainstate& snapshot_chainstate,
@@ -878,6 +956,18 @@ private:
         BlockValidationState& state,
         CBlockIndex** ppindex,
         bool min_pow_checked) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    /**
+     * As above, for a header whose hash was computed by the caller, and which
+     * already passed CheckBlockHeader if header_checked is true, so that this
+     * work can be done without holding cs_main.
+     */
+    bool AcceptBlockHeader(
+        const CBlockHeader& block,
+        const uint256& hash,
+        bool header_checked,
+        BlockValidationState& state,
+        CBlockIndex** ppindex,
+        bool min_pow_checked) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     friend Chainstate;
 
     /** Most recent headers presync progress update, for rate-limiting. */
@@ -933,6 +1023,9 @@ public:
     const util::SignalInterrupt& m_interrupt;
     const Options m_options;
     std::thread m_thread_load;
+    //! Computes the PoW hashes missing from the block index database (with
+    //! -persistpowhashes), and exits once none are left.
+    std::thread m_thread_pow_backfill;
     //! A single BlockManager instance is shared across each constructed
     //! chainstate to avoid duplicating block metadata.
     node::BlockManager m_blockman;
@@ -1135,9 +1228,32 @@ public:
      */
     bool ProcessNewBlock(const std::shared_ptr<const CBlock>& block, bool force_processing, bool min_pow_checked, bool* new_block) LOCKS_EXCLUDED(cs_main);
 
+    /**
+     * Read the coins a block spends from the coins database into the coins
+     * cache, on the coins prefetching worker threads, so that connecting the
+     * block does not have to read them one after another. Call this once the
+     * block is received, before processing it. Does nothing for blocks that
+     * are stored already, or if there are no worker threads.
+     */
+    void PrefetchCoins(const CBlock& block) EXCLUSIVE_LOCKS_REQUIRED(!m_prefetch_mutex) LOCKS_EXCLUDED(cs_main);
+
+    /**
+     * Wait for PrefetchCoins() calls to be done reading from the coins
+     * database, before it is resized or the active chainstate is replaced.
+     * No new ones start reading until cs_main is released.
+     */
+    void WaitForCoinsPrefetch() EXCLUSIVE_LOCKS_REQUIRED(::cs_main, !m_prefetch_mutex);
+
+    //! Counters for the getcoinsprefetchinfo RPC.
+    CoinsPrefetchStats m_prefetch_stats GUARDED_BY(::cs_main);
+
     /**
      * Process incoming block headers.
      *
+     * The headers are hashed and the proof of work of those not yet in the
+     * block index is checked before cs_main is taken, which is then held once
+     * to add the whole batch to the block index.
+     *
      * May not be called in a
      * validationinterface callback.
      *
@@ -1145,8 +1261,9 @@ public:
      * @param[in]  min_pow_checked  True if proof-of-work anti-DoS checks have been done by caller for headers chain
      * @param[out] state This may be set to an Error state if any error occurred processing them
      * @param[out] ppindex If set, the pointer will be set to point to the last new block index object for the given headers
+     * @param[in]  pow_checked  Number of headers, from the front, whose proof of work the caller has already checked, so it is not checked again
      */
-    bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& block, bool min_pow_checked, BlockValidationState& state, const CBlockIndex** ppindex = nullptr) LOCKS_EXCLUDED(cs_main);
+    bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& block, bool min_pow_checked, BlockValidationState& state, const CBlockIndex** ppindex = nullptr, size_t pow_checked = 0) LOCKS_EXCLUDED(cs_main);
 
     /**
      * Sufficiently validate a block for disk storage (and store on disk).
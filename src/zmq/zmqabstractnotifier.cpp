@@ -42,3 +42,8 @@ bool CZMQAbstractNotifier::NotifyTransactionRemoval(const CTransaction &/*transa
 {
     return true;
 }
+
+bool CZMQAbstractNotifier::NotifyBlockTemplate(const node::BlockTemplateSnapshot& /*snapshot*/)
+{
+    return true;
+}
@@ -13,6 +13,9 @@
 class CBlockIndex;
 class CTransaction;
 class CZMQAbstractNotifier;
+namespace node {
+struct BlockTemplateSnapshot;
+} // namespace node
 
 using CZMQNotifierFactory = std::function<std::unique_ptr<CZMQAbstractNotifier>()>;
 
@@ -56,6 +59,8 @@ public:
     virtual bool NotifyTransactionRemoval(const CTransaction &transaction, uint64_t mempool_sequence);
     // Notifies of transactions added to mempool or appearing in blocks
     virtual bool NotifyTransaction(const CTransaction &transaction);
+    // Notifies of every block template built or updated for the active tip
+    virtual bool NotifyBlockTemplate(const node::BlockTemplateSnapshot& snapshot);
 
 protected:
     void* psocket{nullptr};
@@ -50,6 +50,7 @@ std::unique_ptr<CZMQNotificationInterface> CZMQNotificationInterface::Create(std
     };
     factories["pubrawtx"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionNotifier>;
     factories["pubsequence"] = CZMQAbstractNotifier::Create<CZMQPublishSequenceNotifier>;
+    factories["pubblocktemplate"] = CZMQAbstractNotifier::Create<CZMQPublishBlockTemplateNotifier>;
 
     std::list<std::unique_ptr<CZMQAbstractNotifier>> notifiers;
     for (const auto& entry : factories)
@@ -204,4 +205,11 @@ void CZMQNotificationInterface::BlockDisconnected(const std::shared_ptr<const CB
     });
 }
 
+void CZMQNotificationInterface::BlockTemplateUpdated(const node::BlockTemplateSnapshot& snapshot)
+{
+    TryForEachAndRemoveFailed(notifiers, [&snapshot](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyBlockTemplate(snapshot);
+    });
+}
+
 std::unique_ptr<CZMQNotificationInterface> g_zmq_notification_interface;
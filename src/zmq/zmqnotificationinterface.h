@@ -16,6 +16,9 @@
 class CBlock;
 class CBlockIndex;
 class CZMQAbstractNotifier;
+namespace node {
+struct BlockTemplateSnapshot;
+} // namespace node
 
 class CZMQNotificationInterface final : public CValidationInterface
 {
@@ -26,6 +29,9 @@ public:
 
     static std::unique_ptr<CZMQNotificationInterface> Create(std::function<bool(CBlock&, const CBlockIndex&)> get_block_by_index);
 
+    /** Publish a block template. Call it from the validation interface queue, like the notifications below. */
+    void BlockTemplateUpdated(const node::BlockTemplateSnapshot& snapshot);
+
 protected:
     bool Initialize();
     void Shutdown();
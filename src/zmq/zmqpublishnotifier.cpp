@@ -6,12 +6,15 @@
 
 #include <chain.h>
 #include <chainparams.h>
+#include <consensus/amount.h>
+#include <consensus/merkle.h>
 #include <crypto/common.h>
 #include <kernel/cs_main.h>
 #include <logging.h>
 #include <netaddress.h>
 #include <netbase.h>
 #include <node/blockstorage.h>
+#include <node/blocktemplatecache.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <rpc/server.h>
@@ -46,6 +49,7 @@ static const char *MSG_HASHTX    = "hashtx";
 static const char *MSG_RAWBLOCK  = "rawblock";
 static const char *MSG_RAWTX     = "rawtx";
 static const char *MSG_SEQUENCE  = "sequence";
+static const char *MSG_BLOCKTEMPLATE = "blocktemplate";
 
 // Internal function to send multipart message
 static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
@@ -265,6 +269,16 @@ bool CZMQPublishRawTransactionNotifier::NotifyTransaction(const CTransaction &tr
     return SendZmqMessage(MSG_RAWTX, &(*ss.begin()), ss.size());
 }
 
+bool CZMQPublishBlockTemplateNotifier::NotifyBlockTemplate(const node::BlockTemplateSnapshot& snapshot)
+{
+    const CBlock& block{snapshot.tmpl.block};
+    LogPrint(BCLog::ZMQ, "Publish blocktemplate %u on %s to %s\n", snapshot.id, block.hashPrevBlock.GetHex(), this->address);
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << snapshot.id << block.hashPrevBlock << block.nVersion << block.nTime << block.nBits << int32_t{snapshot.prev->nHeight + 1};
+    ss << CAmount{block.vtx[0]->vout[0].nValue} << snapshot.tmpl.vchCoinbaseCommitment << BlockMerkleBranch(block);
+    return SendZmqMessage(MSG_BLOCKTEMPLATE, &(*ss.begin()), ss.size());
+}
+
 // Helper function to send a 'sequence' topic message with the following structure:
 //    <32-byte hash> | <1-byte label> | <8-byte LE sequence> (optional)
 static bool SendSequenceMsg(CZMQAbstractPublishNotifier& notifier, uint256 hash, char label, std::optional<uint64_t> sequence = {})
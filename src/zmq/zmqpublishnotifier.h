@@ -63,6 +63,12 @@ public:
     bool NotifyTransaction(const CTransaction &transaction) override;
 };
 
+class CZMQPublishBlockTemplateNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyBlockTemplate(const node::BlockTemplateSnapshot& snapshot) override;
+};
+
 class CZMQPublishSequenceNotifier : public CZMQAbstractPublishNotifier
 {
 public:
@@ -4,6 +4,7 @@
 # file COPYING or http://www.opensource.org/licenses/mit-license.php.
 """Test the ZMQ notification interface."""
 import struct
+from io import BytesIO
 from time import sleep
 
 from test_framework.address import (
@@ -11,17 +12,22 @@ from test_framework.address import (
     ADDRESS_BCRT1_UNSPENDABLE,
 )
 from test_framework.blocktools import (
+    NORMAL_GBT_REQUEST_PARAMS,
     add_witness_commitment,
     create_block,
     create_coinbase,
 )
 from test_framework.test_framework import BitcoinTestFramework
 from test_framework.messages import (
+    deser_string,
+    deser_uint256,
+    deser_uint256_vector,
     hash256,
     tx_from_hex,
 )
 from test_framework.util import (
     assert_equal,
+    assert_greater_than,
     assert_raises_rpc_error,
     p2p_port,
 )
@@ -82,8 +88,8 @@ class ZMQTestSetupBlock:
     Generates a block on the specified node on instantiation and provides a
     method to check whether a ZMQ notification matches, i.e. the event was
     caused by this generated block.  Assumes that a notification either contains
-    the generated block's hash, it's (coinbase) transaction id, the raw block or
-    raw transaction data.
+    the generated block's hash (in either byte order), it's (coinbase) transaction
+    id, the raw block or raw transaction data.
     """
     def __init__(self, test_framework, node):
         self.block_hash = test_framework.generate(node, 1, sync_fun=test_framework.no_op)[0]
@@ -95,6 +101,7 @@ class ZMQTestSetupBlock:
     def caused_notification(self, notification):
         return (
             self.block_hash in notification
+            or bytes.fromhex(self.block_hash)[::-1].hex() in notification
             or self.tx_hash in notification
             or self.raw_block in notification
             or self.raw_tx in notification
@@ -120,6 +127,7 @@ class ZMQTest (BitcoinTestFramework):
             self.test_basic()
             self.test_sequence()
             self.test_mempool_sync()
+            self.test_blocktemplate()
             self.test_reorg()
             self.test_multiple_interfaces()
             self.test_ipv6()
@@ -243,6 +251,46 @@ class ZMQTest (BitcoinTestFramework):
 
         assert_equal(self.nodes[1].getzmqnotifications(), [])
 
+    def test_blocktemplate(self):
+        self.log.info("Testing the blocktemplate publisher")
+        address = f"tcp://127.0.0.1:{self.zmq_port_base}"
+        subscriber = self.setup_zmq_test([("blocktemplate", address)])[0]
+
+        def receive_template():
+            f = BytesIO(subscriber.receive())
+            template = {}
+            template["id"], = struct.unpack("<Q", f.read(8))
+            template["previousblockhash"] = f"{deser_uint256(f):064x}"
+            template["version"], template["curtime"], template["bits"], template["height"], template["coinbasevalue"] = struct.unpack("<iIIiq", f.read(28))
+            template["default_witness_commitment"] = deser_string(f).hex()
+            template["merkle_branch"] = [f"{h:064x}" for h in deser_uint256_vector(f)]
+            assert_equal(f.read(), b"")
+            return template
+
+        self.log.info("A template is published for every new tip")
+        tip = self.generatetoaddress(self.nodes[0], 1, ADDRESS_BCRT1_UNSPENDABLE)[0]
+        template = receive_template()
+        while template["previousblockhash"] != tip:
+            template = receive_template()
+        gbt = self.nodes[0].getblocktemplate(NORMAL_GBT_REQUEST_PARAMS)
+        assert_equal(template["previousblockhash"], gbt["previousblockhash"])
+        assert_equal(f"{template['bits']:08x}", gbt["bits"])
+        assert_equal(template["height"], gbt["height"])
+
+        self.log.info("A transaction entering the mempool is published with the template it went into")
+        txid = self.wallet.send_self_transfer(from_node=self.nodes[0])["txid"]
+        updated = receive_template()
+        assert_greater_than(updated["id"], template["id"])
+        assert_equal(updated["previousblockhash"], tip)
+        assert_greater_than(updated["coinbasevalue"], template["coinbasevalue"])
+        gbt = self.nodes[0].getblocktemplate(NORMAL_GBT_REQUEST_PARAMS)
+        assert txid in [tx["txid"] for tx in gbt["transactions"]]
+        assert_equal(updated["coinbasevalue"], gbt["coinbasevalue"])
+        assert_equal(updated["default_witness_commitment"], gbt["default_witness_commitment"])
+        if len(gbt["transactions"]) == 1:
+            assert_equal(updated["merkle_branch"], [txid])
+        self.generatetoaddress(self.nodes[0], 1, ADDRESS_BCRT1_UNSPENDABLE)
+
     def test_reorg(self):
 
         address = f"tcp://127.0.0.1:{self.zmq_port_base}"
@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""
+Test that IBD from a distant peer is pipelined: the node keeps enough blocks in
+flight to cover the peer's round-trip time, and adapts that number to it,
+instead of waiting a round trip for every few blocks.
+"""
+
+import shutil
+
+from test_framework.messages import (
+        CBlock,
+        MSG_BLOCK,
+        MSG_TYPE_MASK,
+        from_hex,
+        msg_block,
+        msg_pong,
+)
+from test_framework.p2p import (
+        NetworkThread,
+        P2PDataStore,
+)
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import (
+        assert_equal,
+        assert_greater_than,
+)
+
+# Round-trip time emulated by the stand-in peer, in seconds.
+LATENCY = 0.2
+# Number of blocks the node keeps in flight from a peer before it measured its download rate.
+MIN_BLOCKS_IN_TRANSIT_PER_PEER = 160
+# Number of blocks to sync, enough for the in-flight window to grow past its initial size.
+NUM_BLOCKS = 3 * MIN_BLOCKS_IN_TRANSIT_PER_PEER
+
+
+class P2PDistantPeer(P2PDataStore):
+    """Stand-in for a distant peer: answers pings and block requests after LATENCY seconds.
+
+    Keeps track of the largest number of blocks requested from it that it had not answered yet."""
+
+    def __init__(self):
+        super().__init__()
+        self.blocks_pending = 0
+        self.max_blocks_pending = 0
+
+    def send_delayed(self, message):
+        NetworkThread.network_event_loop.call_later(LATENCY, self.send_message, message)
+
+    def send_block_delayed(self, block):
+        def send_block():
+            self.blocks_pending -= 1
+            self.send_message(msg_block(block))
+        NetworkThread.network_event_loop.call_later(LATENCY, send_block)
+
+    def on_ping(self, message):
+        self.send_delayed(msg_pong(message.nonce))
+
+    def on_getdata(self, message):
+        for inv in message.inv:
+            self.getdata_requests.append(inv.hash)
+            if (inv.type & MSG_TYPE_MASK) == MSG_BLOCK:
+                self.blocks_pending += 1
+                self.max_blocks_pending = max(self.max_blocks_pending, self.blocks_pending)
+                self.send_block_delayed(self.block_store[inv.hash])
+
+
+class P2PIBDPipeliningTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+
+    def run_test(self):
+        node = self.nodes[0]
+
+        self.log.info(f"Mine up to {NUM_BLOCKS} blocks, take them and restart the node from genesis")
+        self.generate(node, NUM_BLOCKS - node.getblockcount(), sync_fun=self.no_op)
+        blocks = []
+        for height in range(1, node.getblockcount() + 1):
+            block = from_hex(CBlock(), node.getblock(node.getblockhash(height), 0))
+            block.rehash()
+            blocks.append(block)
+        self.stop_node(0)
+        for subdir in ["blocks", "chainstate"]:
+            shutil.rmtree(node.chain_path / subdir)
+        self.start_node(0)
+        assert_equal(node.getblockcount(), 0)
+
+        self.log.info(f"Sync {len(blocks)} blocks from a peer {LATENCY}s away")
+        peer = P2PDistantPeer()
+        for block in blocks:
+            peer.block_store[block.sha256] = block
+        peer.last_block_hash = blocks[-1].sha256
+        node.add_outbound_p2p_connection(peer, p2p_idx=0, connection_type="outbound-full-relay")
+        self.wait_until(lambda: node.getblockcount() == len(blocks))
+
+        # Blocks arrive much faster than the round trip, so the node widened the
+        # in-flight window for this peer, and kept more blocks requested from it
+        # at once than it would have with the initial window.
+        assert_greater_than(node.getpeerinfo()[0]["inflight_limit"], MIN_BLOCKS_IN_TRANSIT_PER_PEER)
+        self.log.info(f"Up to {peer.max_blocks_pending} blocks were requested from the peer at once")
+        assert_greater_than(peer.max_blocks_pending, MIN_BLOCKS_IN_TRANSIT_PER_PEER)
+
+
+if __name__ == '__main__':
+    P2PIBDPipeliningTest().main()
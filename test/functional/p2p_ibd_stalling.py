@@ -50,7 +50,9 @@ class P2PIBDStallingTest(BitcoinTestFramework):
         self.num_nodes = 1
 
     def run_test(self):
-        NUM_BLOCKS = 1025
+        # Small blocks let the block download window grow to its upper bound
+        # of 4096 blocks.
+        NUM_BLOCKS = 4097
         NUM_PEERS = 4
         node = self.nodes[0]
         tip = int(node.getbestblockhash(), 16)
@@ -68,19 +70,24 @@ class P2PIBDStallingTest(BitcoinTestFramework):
             block_dict[blocks[-1].sha256] = blocks[-1]
         stall_block = blocks[0].sha256
 
-        headers_message = msg_headers()
-        headers_message.headers = [CBlockHeader(b) for b in blocks[:NUM_BLOCKS-1]]
+        # A headers message holds at most 2000 headers.
+        headers_messages = []
+        for i in range(0, NUM_BLOCKS - 1, 2000):
+            headers_messages.append(msg_headers([CBlockHeader(b) for b in blocks[i:min(i + 2000, NUM_BLOCKS - 1)]]))
         peers = []
 
-        self.log.info("Check that a staller does not get disconnected if the 1024 block lookahead buffer is filled")
+        self.log.info("Check that a staller does not get disconnected if the 4096 block lookahead buffer is filled")
         for id in range(NUM_PEERS):
             peers.append(node.add_outbound_p2p_connection(P2PStaller(stall_block), p2p_idx=id, connection_type="outbound-full-relay"))
             peers[-1].block_store = block_dict
-            peers[-1].send_message(headers_message)
+            for headers_message in headers_messages:
+                peers[-1].send_message(headers_message)
 
-        # Need to wait until 1023 blocks are received - the magic total bytes number is a workaround in lack of an rpc
-        # returning the number of downloaded (but not connected) blocks.
-        self.wait_until(lambda: self.total_bytes_recv_for_blocks() == 172761)
+        # Need to wait until 4095 blocks are received - the total bytes number is a workaround in lack of an rpc
+        # returning the number of downloaded (but not connected) blocks. Each block message is counted with a 24 byte
+        # message header.
+        expected_bytes = sum(24 + len(b.serialize()) for b in blocks[1:NUM_BLOCKS-1])
+        self.wait_until(lambda: self.total_bytes_recv_for_blocks() == expected_bytes)
 
         self.all_sync_send_with_ping(peers)
         # If there was a peer marked for stalling, it would get disconnected
@@ -89,8 +96,8 @@ class P2PIBDStallingTest(BitcoinTestFramework):
         self.all_sync_send_with_ping(peers)
         assert_equal(node.num_test_p2p_connections(), NUM_PEERS)
 
-        self.log.info("Check that increasing the window beyond 1024 blocks triggers stalling logic")
-        headers_message.headers = [CBlockHeader(b) for b in blocks]
+        self.log.info("Check that increasing the window beyond 4096 blocks triggers stalling logic")
+        headers_message = msg_headers([CBlockHeader(blocks[-1])])
         with node.assert_debug_log(expected_msgs=['Stall started']):
             for p in peers:
                 p.send_message(headers_message)
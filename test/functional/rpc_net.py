@@ -133,6 +133,7 @@ class NetTest(BitcoinTestFramework):
                 "id": no_version_peer_id,
                 "inbound": True,
                 "inflight": [],
+                "inflight_limit": 160,
                 "last_block": 0,
                 "last_transaction": 0,
                 "lastrecv": 0,
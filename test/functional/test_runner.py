@@ -279,6 +279,7 @@ BASE_SCRIPTS = [
     'p2p_eviction.py',
     'p2p_ibd_stalling.py',
     'p2p_ibd_stalling.py --v2transport',
+    'p2p_ibd_pipelining.py',
     'p2p_net_deadlock.py',
     'p2p_net_deadlock.py --v2transport',
     'wallet_signmessagewithaddress.py',